@@ -0,0 +1,403 @@
+// include the necessary libraries
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <iomanip>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+// use the standard namespace
+using namespace std;
+
+// values used in the header of every generated trace
+const int BENCH_PAGE_SIZE = 4096;
+const int BENCH_NUM_FRAMES = 1024;
+const int BENCH_NUM_PAGES = 16384;
+const int BENCH_NUM_BS_BLOCKS = 16384;
+
+// percent of the references that are writes
+const int BENCH_WRITE_PERCENT = 30;
+
+// number of references in each phase of the phase-changing workload
+const long long BENCH_PHASE_LENGTH = 100000;
+
+// folder the generated traces are kept in
+const string BENCH_TRACE_DIR = "bench_traces";
+
+// struct for the settings of a benchmark run
+struct BenchSettings
+{
+    long long references;
+    unsigned long long seed;
+    vector<string> workloads;
+    vector<string> algorithms;
+    string vm_path;
+    vector<int> opt_windows;
+};
+
+// class for the page numbers of a workload, every workload is seeded so the same settings give the same trace
+class TraceGenerator
+{
+    public:
+        // variables
+        string workload;
+        mt19937_64 rng;
+        vector<double> zipf_cdf;
+        vector<int> zipf_pages;
+        long long position;
+        int phase_start;
+
+    // constructor
+    TraceGenerator(const string &w, unsigned long long seed) : rng(seed)
+    {
+        workload = w;
+        position = 0;
+        phase_start = 0;
+
+        // the zipf workload draws a popularity rank and maps it to a shuffled page, so popular pages are spread out
+        if (workload == "zipf")
+        {
+            double total = 0;
+            zipf_cdf.resize(BENCH_NUM_PAGES);
+            for (int rank = 0; rank < BENCH_NUM_PAGES; ++rank)
+            {
+                total += 1.0 / (rank + 1);
+                zipf_cdf[rank] = total;
+            }
+            for (double &value : zipf_cdf)
+            {
+                value /= total;
+            }
+            zipf_pages.resize(BENCH_NUM_PAGES);
+            for (int page = 0; page < BENCH_NUM_PAGES; ++page)
+            {
+                zipf_pages[page] = page;
+            }
+            shuffle(zipf_pages.begin(), zipf_pages.end(), rng);
+        }
+    }
+
+    // get a random number in [0, limit)
+    int random_below(int limit)
+    {
+        return uniform_int_distribution<int>(0, limit - 1)(rng);
+    }
+
+    // get the page number of the next reference
+    int next_page()
+    {
+        long long index = position++;
+        if (workload == "uniform")
+        {
+            // every page is equally likely
+            return random_below(BENCH_NUM_PAGES);
+        }
+        if (workload == "zipf")
+        {
+            // a few pages take most of the references
+            double value = uniform_real_distribution<double>(0.0, 1.0)(rng);
+            int rank = lower_bound(zipf_cdf.begin(), zipf_cdf.end(), value) - zipf_cdf.begin();
+            return zipf_pages[min(rank, BENCH_NUM_PAGES - 1)];
+        }
+        if (workload == "sequential")
+        {
+            // scan through every page over and over
+            return index % BENCH_NUM_PAGES;
+        }
+        if (workload == "loop")
+        {
+            // loop over a working set a quarter larger than memory, the worst case for FIFO and LRU
+            return index % (BENCH_NUM_FRAMES + BENCH_NUM_FRAMES / 4);
+        }
+
+        // phase: random references to a working set twice the size of memory, which moves every phase
+        if (index % BENCH_PHASE_LENGTH == 0)
+        {
+            phase_start = random_below(BENCH_NUM_PAGES - 2 * BENCH_NUM_FRAMES);
+        }
+        return phase_start + random_below(2 * BENCH_NUM_FRAMES);
+    }
+
+    // get the operation of the next reference
+    char next_operation()
+    {
+        return random_below(100) < BENCH_WRITE_PERCENT ? 'w' : 'r';
+    }
+};
+
+// check if a workload name is one the generator knows
+bool is_workload(const string &workload)
+{
+    return workload == "uniform" || workload == "zipf" || workload == "sequential" || workload == "loop" || workload == "phase";
+}
+
+// write a trace file for the workload, returns false if the file could not be written
+bool generate_trace(const string &workload, long long references, unsigned long long seed, const string &filename)
+{
+    // write to a temporary file first so a cancelled run never leaves half a trace behind
+    string temp_filename = filename + ".tmp";
+    ofstream file(temp_filename);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    // write the header and the references
+    file << "# " << workload << " workload, " << references << " references, seed " << seed << "\n";
+    file << BENCH_PAGE_SIZE << " " << BENCH_NUM_FRAMES << " " << BENCH_NUM_PAGES << " " << BENCH_NUM_BS_BLOCKS << "\n";
+    TraceGenerator generator(workload, seed);
+    file << hex;
+    for (long long i = 0; i < references; ++i)
+    {
+        char operation = generator.next_operation();
+        long long address = (long long)generator.next_page() * BENCH_PAGE_SIZE + generator.random_below(BENCH_PAGE_SIZE);
+        file << operation << " " << address << "\n";
+    }
+    file.close();
+    if (!file)
+    {
+        return false;
+    }
+    return rename(temp_filename.c_str(), filename.c_str()) == 0;
+}
+
+// run the simulator with the given arguments and measure the wall time and peak memory of the run, the output goes to
+// output_filename (or is thrown away if it is empty), returns false if it failed
+bool run_simulator(const string &vm_path, const vector<string> &arguments, const string &output_filename, double &seconds, long &peak_rss_kb)
+{
+    auto start = chrono::steady_clock::now();
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        return false;
+    }
+    if (pid == 0)
+    {
+        // the child throws its output away unless it is needed, so only the simulation is measured
+        int output_fd = output_filename == "" ? open("/dev/null", O_WRONLY) : open(output_filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (output_fd >= 0)
+        {
+            dup2(output_fd, STDOUT_FILENO);
+            close(output_fd);
+        }
+        vector<char *> argv = {(char *)vm_path.c_str()};
+        for (const string &argument : arguments)
+        {
+            argv.push_back((char *)argument.c_str());
+        }
+        argv.push_back(nullptr);
+        execv(vm_path.c_str(), argv.data());
+        _exit(127);
+    }
+
+    // wait for the child and get its peak resident set size
+    int status;
+    struct rusage usage;
+    if (wait4(pid, &status, 0, &usage) < 0)
+    {
+        return false;
+    }
+    seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    peak_rss_kb = usage.ru_maxrss;
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// get the page miss instances from the output of the simulator, returns -1 if they are not there
+long long read_page_misses(const string &filename)
+{
+    ifstream file(filename);
+    string line;
+    const string prefix = "Page miss instances: ";
+    long long misses = -1;
+    while (getline(file, line))
+    {
+        if (line.compare(0, prefix.size(), prefix) == 0)
+        {
+            misses = atoll(line.c_str() + prefix.size());
+        }
+    }
+    return misses;
+}
+
+// run OPTIMAL on a trace with each lookahead window and compare its page misses to OPT that knows the whole trace,
+// returns false if a run failed
+bool compare_opt_windows(const BenchSettings &settings, const string &workload, const string &filename)
+{
+    // get the page misses of the true OPT first
+    string output_filename = BENCH_TRACE_DIR + "/opt.out";
+    double seconds;
+    long peak_rss_kb;
+    if (!run_simulator(settings.vm_path, {"OPTIMAL", filename}, output_filename, seconds, peak_rss_kb))
+    {
+        cout << left << setw(12) << workload << right << setw(10) << "FAILED" << endl;
+        return false;
+    }
+    long long opt_misses = read_page_misses(output_filename);
+    cout << left << setw(12) << workload << setw(10) << "full" << right << setw(14) << opt_misses << setw(10) << "0.00" << fixed << setprecision(3) << setw(10) << seconds << setw(14) << peak_rss_kb << endl;
+
+    // then each window, which can only miss as often or more
+    for (int window : settings.opt_windows)
+    {
+        cout << left << setw(12) << workload << setw(10) << window << right;
+        if (!run_simulator(settings.vm_path, {"--opt-window", to_string(window), "OPTIMAL", filename}, output_filename, seconds, peak_rss_kb))
+        {
+            cout << setw(14) << "FAILED" << endl;
+            return false;
+        }
+        long long misses = read_page_misses(output_filename);
+        double gap = opt_misses > 0 ? 100.0 * (misses - opt_misses) / opt_misses : 0.0;
+        cout << setw(14) << misses << fixed << setprecision(2) << setw(10) << gap << setprecision(3) << setw(10) << seconds << setw(14) << peak_rss_kb << endl;
+    }
+    unlink(output_filename.c_str());
+    return true;
+}
+
+// split a comma separated list
+vector<string> split_list(const string &value)
+{
+    vector<string> items;
+    stringstream ss(value);
+    string item;
+    while (getline(ss, item, ','))
+    {
+        if (item != "")
+        {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+int main(int argc, char *argv[])
+{
+    // default settings
+    BenchSettings settings = {1000000, 1, {"uniform", "zipf", "sequential", "loop", "phase"}, {"FIFO", "LRU", "OPTIMAL"}, "./vm", {}};
+
+    // read the flags
+    for (int arg_index = 1; arg_index < argc; arg_index += 2)
+    {
+        string flag = argv[arg_index];
+        if (arg_index + 1 >= argc)
+        {
+            cout << "Usage: " << argv[0] << " [--refs <references>] [--seed <seed>] [--workloads <list>] [--algorithms <list>] [--vm <path>] [--opt-windows <list>]" << endl;
+            return 1;
+        }
+        string value = argv[arg_index + 1];
+        if (flag == "--refs")
+        {
+            settings.references = atoll(value.c_str());
+        }
+        else if (flag == "--seed")
+        {
+            settings.seed = strtoull(value.c_str(), nullptr, 10);
+        }
+        else if (flag == "--workloads")
+        {
+            settings.workloads = split_list(value);
+        }
+        else if (flag == "--algorithms")
+        {
+            settings.algorithms = split_list(value);
+        }
+        else if (flag == "--vm")
+        {
+            settings.vm_path = value;
+        }
+        else if (flag == "--opt-windows")
+        {
+            for (const string &window : split_list(value))
+            {
+                settings.opt_windows.push_back(atoi(window.c_str()));
+            }
+        }
+        else
+        {
+            cout << "Invalid argument" << endl;
+            return 1;
+        }
+    }
+
+    // check the settings
+    if (settings.references <= 0)
+    {
+        cout << "Invalid number of references" << endl;
+        return 1;
+    }
+    for (const string &workload : settings.workloads)
+    {
+        if (!is_workload(workload))
+        {
+            cout << "Invalid workload: " << workload << endl;
+            return 1;
+        }
+    }
+    for (int window : settings.opt_windows)
+    {
+        if (window <= 0)
+        {
+            cout << "Invalid OPT window" << endl;
+            return 1;
+        }
+    }
+
+    // print the settings
+    cout << "References: " << settings.references << endl;
+    cout << "Seed: " << settings.seed << endl;
+    cout << "Page size: " << BENCH_PAGE_SIZE << " Num frames: " << BENCH_NUM_FRAMES << " Num pages: " << BENCH_NUM_PAGES << endl;
+    cout << left << setw(12) << "workload" << setw(10) << "algorithm" << right << setw(10) << "seconds" << setw(14) << "refs/s" << setw(14) << "peak RSS KB" << endl;
+
+    // generate each trace once and run every algorithm on it
+    mkdir(BENCH_TRACE_DIR.c_str(), 0755);
+    int exit_value = 0;
+    for (const string &workload : settings.workloads)
+    {
+        // the trace is only generated if it is not already there, the name has everything that changes its contents
+        string filename = BENCH_TRACE_DIR + "/" + workload + "." + to_string(settings.references) + "." + to_string(settings.seed);
+        if (access(filename.c_str(), R_OK) != 0 && !generate_trace(workload, settings.references, settings.seed, filename))
+        {
+            cout << "Could not write trace " << filename << endl;
+            return 1;
+        }
+
+        for (const string &algorithm : settings.algorithms)
+        {
+            double seconds;
+            long peak_rss_kb;
+            cout << left << setw(12) << workload << setw(10) << algorithm << right;
+            if (!run_simulator(settings.vm_path, {algorithm, filename}, "", seconds, peak_rss_kb))
+            {
+                cout << setw(10) << "FAILED" << endl;
+                exit_value = 1;
+                continue;
+            }
+            cout << fixed << setprecision(3) << setw(10) << seconds << setprecision(0) << setw(14) << settings.references / seconds << setw(14) << peak_rss_kb << endl;
+        }
+    }
+
+    // compare windowed OPT to the true OPT on each trace if windows were given
+    if (!settings.opt_windows.empty())
+    {
+        cout << endl;
+        cout << left << setw(12) << "workload" << setw(10) << "window" << right << setw(14) << "page misses" << setw(10) << "gap %" << setw(10) << "seconds" << setw(14) << "peak RSS KB" << endl;
+        for (const string &workload : settings.workloads)
+        {
+            string filename = BENCH_TRACE_DIR + "/" + workload + "." + to_string(settings.references) + "." + to_string(settings.seed);
+            if (!compare_opt_windows(settings, workload, filename))
+            {
+                exit_value = 1;
+            }
+        }
+    }
+    return exit_value;
+}
@@ -0,0 +1,114 @@
+// header for the checkpoint files the vm program and the virtual memory library save a run to and resume it from
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+// include the necessary libraries
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// first bytes of every checkpoint file, the last two digits are the version of the format
+const char CHECKPOINT_MAGIC[8] = {'V', 'M', 'C', 'K', 'P', 'T', '0', '8'};
+
+// class for building a binary checkpoint in memory and writing it to a file atomically
+class CheckpointWriter
+{
+    public:
+        // variables
+        std::string data;
+
+    // add a value that can be copied byte for byte
+    template <class T>
+    void put(const T &value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "checkpoint values must be trivially copyable");
+        data.append((const char *)&value, sizeof(T));
+    }
+
+    // add a vector with its length in front
+    template <class T>
+    void put_vector(const std::vector<T> &values)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "checkpoint values must be trivially copyable");
+        put((uint64_t)values.size());
+        data.append((const char *)values.data(), values.size() * sizeof(T));
+    }
+
+    // add a string with its length in front
+    void put_string(const std::string &value)
+    {
+        put((uint64_t)value.size());
+        data.append(value);
+    }
+
+    // write the checkpoint to a temporary file, sync it, and rename it over the old checkpoint,
+    // so a crash at any point leaves either the old or the new checkpoint and never half of one
+    bool write_file(const std::string &filename);
+};
+
+// class for reading back a checkpoint written by CheckpointWriter, ok turns false if the file is cut short
+class CheckpointReader
+{
+    public:
+        // variables
+        std::string data;
+        size_t position;
+        bool ok;
+
+    // constructor
+    CheckpointReader()
+    {
+        position = 0;
+        ok = false;
+    }
+
+    // read the whole checkpoint file and check the magic bytes
+    bool read_file(const std::string &filename);
+
+    // read a value that was copied byte for byte
+    template <class T>
+    void get(T &value)
+    {
+        if (!ok || position + sizeof(T) > data.size())
+        {
+            ok = false;
+            return;
+        }
+        std::memcpy((void *)&value, data.data() + position, sizeof(T));
+        position += sizeof(T);
+    }
+
+    // read a vector with its length in front
+    template <class T>
+    void get_vector(std::vector<T> &values)
+    {
+        uint64_t size = 0;
+        get(size);
+        if (!ok || size > (data.size() - position) / sizeof(T))
+        {
+            ok = false;
+            return;
+        }
+        values.resize(size);
+        std::memcpy((void *)values.data(), data.data() + position, size * sizeof(T));
+        position += size * sizeof(T);
+    }
+
+    // read a string with its length in front
+    void get_string(std::string &value)
+    {
+        uint64_t size = 0;
+        get(size);
+        if (!ok || size > data.size() - position)
+        {
+            ok = false;
+            return;
+        }
+        value = data.substr(position, size);
+        position += size;
+    }
+};
+
+#endif
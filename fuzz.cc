@@ -0,0 +1,867 @@
+// a differential fuzzer that runs random traces through the original FIFO, LRU, and OPT implementations and through the
+// engines in libvm side by side, and shrinks any trace they disagree on to a minimal one
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <sstream>
+#include <vector>
+#include <iomanip>
+#include <unordered_map>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <array>
+#include "vm.h"
+
+// use the standard namespace
+using namespace std;
+
+// the largest sizes a generated trace is given
+const int FUZZ_MAX_FRAMES = 16;
+const int FUZZ_MAX_PAGES = 48;
+const int FUZZ_MAX_REFERENCES = 160;
+
+// page sizes a trace is generated with (a page size of 1 makes every address its own page)
+const vector<int> FUZZ_PAGE_SIZES = {1, 2, 3, 16, 100, 1024, 4096};
+
+// percents of the references that are writes a trace is generated with
+const vector<int> FUZZ_WRITE_PERCENTS = {0, 10, 30, 50, 90, 100};
+
+// number of cases between progress lines
+const long long FUZZ_PROGRESS_INTERVAL = 100000;
+
+// file the shrunk trace of a divergence is written to
+const string FUZZ_FAILURE_FILENAME = "fuzz_failure.trace";
+
+// the original implementation of the algorithms, as it was before the engines were optimized (only the debug output is
+// left out), kept in its own namespace so its tables do not clash with the ones in vm.h
+namespace baseline
+{
+    // struct for the values of each of the pages
+    struct Page
+    {
+        int page_number;
+        PageType type;
+        int frame_number;
+        int on_disk;
+    };
+
+    // struct for the values of each of the frames
+    struct Frame
+    {
+        int frame_number;
+        int page_number;
+        int in_use;
+        int dirty;
+        int first_use;
+        int last_use;
+    };
+
+    // class for the virtual memory
+    class VirtualMemory
+    {
+        public:
+            // variables
+            int page_size;
+            int num_frames;
+            int num_pages;
+            int num_bs_blocks;
+            vector<Frame> frames;
+            vector<Page> pages;
+            vector<int> backing_store;
+            int pages_referenced;
+            int pages_mapped;
+            int page_miss_instances;
+            int frame_stolen_instances;
+            int stolen_frames_written_to_swapspace;
+            int stolen_frames_recovered_from_swapspace;
+
+        // constructor
+        VirtualMemory(int ps, int nf, int np, int nbb)
+        {
+            page_size = ps;
+            num_frames = nf;
+            num_pages = np;
+            num_bs_blocks = nbb;
+            pages_referenced = 0;
+            pages_mapped = 0;
+            page_miss_instances = 0;
+            frame_stolen_instances = 0;
+            stolen_frames_written_to_swapspace = 0;
+            stolen_frames_recovered_from_swapspace = 0;
+
+            // initialize the pages and frames
+            pages.resize(num_pages);
+            frames.resize(num_frames);
+            backing_store.resize(max(num_bs_blocks, num_pages), -1); // the original indexes it by page, past the end if there are fewer blocks
+
+            // initialize the pages
+            for (int i = 0; i < num_pages; ++i)
+            {
+                pages[i].page_number = i;
+                pages[i].type = UNUSED;
+                pages[i].frame_number = -1;
+                pages[i].on_disk = 0;
+            }
+
+            // initialize the frames
+            for (int i = 0; i < num_frames; ++i)
+            {
+                frames[i].frame_number = i;
+                frames[i].page_number = -1;
+                frames[i].first_use = -1;
+                frames[i].last_use = -1;
+                frames[i].dirty = 0;
+                frames[i].in_use = 0;
+            }
+        }
+
+        // checks the number of pages mapped (needed to update the page table correctly)
+        void check_pages_mapped()
+        {
+            pages_mapped = 0;
+            for (auto &page : pages)
+            {
+                if (page.type != UNUSED)
+                {
+                    pages_mapped++;
+                }
+            }
+        }
+
+        // run the FIFO algorithm for one instruction
+        void run_fifo_algorithm(const string &instruction)
+        {
+            // get the operation and address
+            char operation = instruction[0];
+            string address_hex = instruction.substr(1);
+            int address = stoi(address_hex, nullptr, 16);
+            int page_number = address / page_size;
+
+            // increment the pages referenced
+            pages_referenced++;
+
+            // check if the page is already in memory
+            for (auto &frame : frames)
+            {
+                if (frame.page_number == page_number)
+                {
+                    frame.last_use = pages_referenced;
+                    if (operation == 'w')
+                    {
+                        frame.dirty = 1;
+                    }
+                    return;
+                }
+            }
+
+            // page miss
+            page_miss_instances++;
+
+            // find an empty frame
+            for (auto &frame : frames)
+            {
+                if (frame.in_use == 0)
+                {
+                    // update the frame table
+                    frame.page_number = page_number;
+                    frame.first_use = pages_referenced;
+                    frame.last_use = pages_referenced;
+                    frame.in_use = 1;
+                    if (operation == 'w')
+                    {
+                        frame.dirty = 1;
+                    }
+
+                    // update the page table
+                    pages[page_number].frame_number = frame.frame_number;
+                    pages[page_number].type = MAPPED;
+                    pages[page_number].on_disk = 0;
+                    return;
+                }
+            }
+
+            // no empty frame found, apply fifo replacement
+            int oldest_frame_index = 0;
+            for (size_t i = 1; i < frames.size(); ++i)
+            {
+                if (frames[i].first_use < frames[oldest_frame_index].first_use)
+                {
+                    oldest_frame_index = i;
+                }
+            }
+            steal_and_fill(frames[oldest_frame_index], page_number, operation);
+        }
+
+        // run the LRU algorithm for one instruction
+        void run_lru_algorithm(const string &instruction)
+        {
+            // get the operation and address
+            char operation = instruction[0];
+            string address_hex = instruction.substr(1);
+            int address = stoi(address_hex, nullptr, 16);
+            int page_number = address / page_size;
+
+            // increment the pages referenced
+            pages_referenced++;
+
+            // check if the page is already in memory
+            for (auto &frame : frames)
+            {
+                if (frame.page_number == page_number)
+                {
+                    frame.last_use = pages_referenced;
+                    if (operation == 'w')
+                    {
+                        frame.dirty = 1;
+                    }
+                    return;
+                }
+            }
+
+            // page miss
+            page_miss_instances++;
+
+            // find an empty frame
+            for (auto &frame : frames)
+            {
+                if (frame.in_use == 0)
+                {
+                    // update the frame table
+                    frame.page_number = page_number;
+                    frame.first_use = pages_referenced;
+                    frame.last_use = pages_referenced;
+                    frame.in_use = 1;
+                    if (operation == 'w')
+                    {
+                        frame.dirty = 1;
+                    }
+
+                    // update the page table
+                    pages[page_number].frame_number = frame.frame_number;
+                    pages[page_number].type = MAPPED;
+                    pages[page_number].on_disk = 0;
+                    return;
+                }
+            }
+
+            // no empty frame found, apply lru replacement
+            int lru_frame_index = 0;
+            for (size_t i = 1; i < frames.size(); ++i)
+            {
+                if (frames[i].last_use < frames[lru_frame_index].last_use)
+                {
+                    lru_frame_index = i;
+                }
+            }
+            steal_and_fill(frames[lru_frame_index], page_number, operation);
+        }
+
+        // run the OPT algorithm for all future instructions
+        void run_opt_algorithm(const vector<string> &instructions)
+        {
+            for (size_t i = 0; i < instructions.size(); ++i)
+            {
+                // get the operation and address
+                string instruction = instructions[i];
+                char operation = instruction[0];
+                string address_hex = instruction.substr(1);
+                int address = stoi(address_hex, nullptr, 16);
+                int page_number = address / page_size;
+
+                // increment the pages referenced
+                pages_referenced++;
+
+                // check if the page is already in memory
+                bool page_hit = false;
+                for (auto &frame : frames)
+                {
+                    if (frame.page_number == page_number)
+                    {
+                        frame.last_use = pages_referenced;
+                        if (operation == 'w')
+                        {
+                            frame.dirty = 1;
+                        }
+                        page_hit = true;
+                        break;
+                    }
+                }
+                if (page_hit)
+                {
+                    continue;
+                }
+
+                // page miss
+                page_miss_instances++;
+
+                // find an empty frame
+                bool empty_frame_found = false;
+                for (auto &frame : frames)
+                {
+                    if (frame.in_use == 0)
+                    {
+                        // update the frame table
+                        frame.page_number = page_number;
+                        frame.first_use = pages_referenced;
+                        frame.last_use = pages_referenced;
+                        frame.in_use = 1;
+                        if (operation == 'w')
+                        {
+                            frame.dirty = 1;
+                        }
+
+                        // update the page table
+                        pages[page_number].frame_number = frame.frame_number;
+                        pages[page_number].type = MAPPED;
+                        pages[page_number].on_disk = 0;
+                        empty_frame_found = true;
+                        break;
+                    }
+                }
+                if (empty_frame_found)
+                {
+                    continue;
+                }
+
+                // no empty frame found, find the future use of each page
+                int opt_frame_index = -1;
+                int farthest_use = -1;
+                unordered_map<int, int> future_use_map;
+                for (size_t j = i + 1; j < instructions.size(); ++j)
+                {
+                    string future_instruction = instructions[j];
+                    string future_address_hex = future_instruction.substr(1);
+                    int future_address = stoi(future_address_hex, nullptr, 16);
+                    int future_page_number = future_address / page_size;
+                    if (future_use_map.find(future_page_number) == future_use_map.end())
+                    {
+                        future_use_map[future_page_number] = j;
+                    }
+                }
+
+                // find the optimal frame
+                for (size_t k = 0; k < frames.size(); ++k)
+                {
+                    int next_use = future_use_map.count(frames[k].page_number) ? future_use_map[frames[k].page_number] : -1;
+                    if (next_use == -1)
+                    {
+                        opt_frame_index = k;
+                        break;
+                    }
+                    else if (next_use > farthest_use)
+                    {
+                        farthest_use = next_use;
+                        opt_frame_index = k;
+                    }
+                }
+                steal_and_fill(frames[opt_frame_index], page_number, operation);
+            }
+        }
+
+        // steal a frame and put the page in it (the same in all three algorithms)
+        void steal_and_fill(Frame &victim_frame, int page_number, char operation)
+        {
+            // write the stolen frame to swapspace if dirty
+            int victim_page_number = victim_frame.page_number;
+            if (victim_frame.dirty)
+            {
+                backing_store[victim_page_number] = victim_frame.page_number;
+                stolen_frames_written_to_swapspace++;
+            }
+
+            // update the page table for the page being replaced
+            pages[victim_page_number].type = STOLEN;
+            pages[victim_page_number].frame_number = -1;
+            if (victim_frame.dirty)
+            {
+                pages[victim_page_number].on_disk = 1;
+            }
+            frame_stolen_instances++;
+
+            // recover the page from swapspace if it was previously written
+            if (pages[page_number].on_disk == 1 && pages[page_number].frame_number == -1)
+            {
+                stolen_frames_recovered_from_swapspace++;
+                backing_store[page_number] = -1;
+            }
+
+            // update the frame and page tables
+            victim_frame.page_number = page_number;
+            victim_frame.first_use = pages_referenced;
+            victim_frame.last_use = pages_referenced;
+            victim_frame.dirty = operation == 'w' ? 1 : 0;
+            pages[page_number].frame_number = victim_frame.frame_number;
+            pages[page_number].type = MAPPED;
+        }
+    };
+}
+
+// enum for the ways the engines in libvm are driven
+enum EngineMode
+{
+    ENGINE_SINGLE,  // one access call per reference
+    ENGINE_BATCH,   // access_batch with runs of references to the same page collapsed into repeat counts
+    ENGINE_WINDOW,  // OPT with a lookahead window as long as the trace, which has to pick the same victims as the true OPT
+};
+
+// names of the engine modes for the report
+const char *ENGINE_MODE_NAMES[] = {"single", "batched", "windowed"};
+
+// struct for one generated trace
+struct FuzzCase
+{
+    int page_size;
+    int num_frames;
+    int num_pages;
+    int num_bs_blocks;
+    vector<Reference> references;
+};
+
+// struct for the tables and counters at the end of a run, in a form both implementations can be compared in
+struct MemorySnapshot
+{
+    vector<array<int, 3>> pages;        // type, frame number, on disk
+    vector<array<long long, 5>> frames; // page number, in use, dirty, first use, last use
+    array<long long, 6> counters;       // referenced, mapped, misses, stolen, written to swapspace, recovered from swapspace
+};
+
+// names of the fields of a snapshot for the report
+const char *PAGE_FIELD_NAMES[] = {"type", "framenum", "ondisk"};
+const char *FRAME_FIELD_NAMES[] = {"page", "inuse", "dirty", "first_use", "last_use"};
+const char *COUNTER_NAMES[] = {"Pages referenced", "Pages mapped", "Page miss instances", "Frame stolen instances", "Stolen frames written to swapspace", "Stolen frames recovered from swapspace"};
+
+// class for generating random traces with varied sizes, write mixes, and access patterns
+class CaseGenerator
+{
+    public:
+        // variables
+        mt19937_64 rng;
+
+    // constructor
+    CaseGenerator(unsigned long long seed) : rng(seed)
+    {
+    }
+
+    // get a random number in [low, high]
+    int random_between(int low, int high)
+    {
+        return uniform_int_distribution<int>(low, high)(rng);
+    }
+
+    // generate the next case
+    FuzzCase next_case()
+    {
+        // pick the sizes, sometimes with fewer backing store blocks than pages so writes overflow the backing store
+        FuzzCase fuzz_case;
+        fuzz_case.page_size = FUZZ_PAGE_SIZES[random_between(0, FUZZ_PAGE_SIZES.size() - 1)];
+        fuzz_case.num_frames = random_between(1, FUZZ_MAX_FRAMES);
+        fuzz_case.num_pages = random_between(1, FUZZ_MAX_PAGES);
+        fuzz_case.num_bs_blocks = random_between(0, 3) == 0 ? random_between(1, fuzz_case.num_pages) : fuzz_case.num_pages + random_between(0, 8);
+        int write_percent = FUZZ_WRITE_PERCENTS[random_between(0, FUZZ_WRITE_PERCENTS.size() - 1)];
+        int num_references = random_between(1, FUZZ_MAX_REFERENCES);
+
+        // pick the access pattern: uniform, a hot set, a loop a little larger or smaller than memory, or a stride
+        int pattern = random_between(0, 3);
+        int hot_pages = random_between(1, max(1, fuzz_case.num_frames));
+        int loop_length = max(1, min(fuzz_case.num_pages, fuzz_case.num_frames + random_between(-1, 2)));
+        int stride = random_between(1, 3);
+        for (int i = 0; i < num_references; ++i)
+        {
+            int page_number;
+            if (pattern == 0)
+            {
+                page_number = random_between(0, fuzz_case.num_pages - 1);
+            }
+            else if (pattern == 1)
+            {
+                page_number = random_between(0, 9) < 8 ? random_between(0, min(hot_pages, fuzz_case.num_pages) - 1) : random_between(0, fuzz_case.num_pages - 1);
+            }
+            else if (pattern == 2)
+            {
+                page_number = i % loop_length;
+            }
+            else
+            {
+                page_number = (i * stride) % fuzz_case.num_pages;
+            }
+            char operation = random_between(0, 99) < write_percent ? 'w' : 'r';
+            int address = page_number * fuzz_case.page_size + random_between(0, fuzz_case.page_size - 1);
+            fuzz_case.references.push_back(Reference{operation, address, 1});
+        }
+        return fuzz_case;
+    }
+};
+
+// write a case as a trace file the vm program can run
+void write_trace(const FuzzCase &fuzz_case, ostream &output)
+{
+    output << fuzz_case.page_size << " " << fuzz_case.num_frames << " " << fuzz_case.num_pages << " " << fuzz_case.num_bs_blocks << "\n";
+    for (const Reference &reference : fuzz_case.references)
+    {
+        output << reference.operation << " " << hex << reference.address << dec << "\n";
+    }
+}
+
+// run a case through the original implementation of an algorithm
+MemorySnapshot run_baseline(const FuzzCase &fuzz_case, Algorithm algorithm)
+{
+    // the original reads the references as instruction lines
+    baseline::VirtualMemory memory(fuzz_case.page_size, fuzz_case.num_frames, fuzz_case.num_pages, fuzz_case.num_bs_blocks);
+    vector<string> instructions;
+    for (const Reference &reference : fuzz_case.references)
+    {
+        stringstream ss;
+        ss << reference.operation << " " << hex << reference.address;
+        instructions.push_back(ss.str());
+    }
+    if (algorithm == Algorithm::OPT)
+    {
+        memory.run_opt_algorithm(instructions);
+    }
+    else
+    {
+        for (const string &instruction : instructions)
+        {
+            algorithm == Algorithm::FIFO ? memory.run_fifo_algorithm(instruction) : memory.run_lru_algorithm(instruction);
+        }
+    }
+    memory.check_pages_mapped();
+
+    // take the snapshot
+    MemorySnapshot snapshot;
+    for (const baseline::Page &page : memory.pages)
+    {
+        snapshot.pages.push_back({(int)page.type, page.frame_number, page.on_disk});
+    }
+    for (const baseline::Frame &frame : memory.frames)
+    {
+        snapshot.frames.push_back({frame.in_use ? frame.page_number : -1, frame.in_use, frame.dirty, frame.first_use, frame.last_use});
+    }
+    snapshot.counters = {memory.pages_referenced, memory.pages_mapped, memory.page_miss_instances, memory.frame_stolen_instances,
+                         memory.stolen_frames_written_to_swapspace, memory.stolen_frames_recovered_from_swapspace};
+    return snapshot;
+}
+
+// run a case through the engine in libvm, driven the way the mode says
+MemorySnapshot run_engine(const FuzzCase &fuzz_case, Algorithm algorithm, EngineMode mode)
+{
+    // create the virtual memory, OPT is given every page number unless it has a window
+    VirtualMemoryConfig config;
+    config.page_size = fuzz_case.page_size;
+    config.num_frames = fuzz_case.num_frames;
+    config.num_pages = fuzz_case.num_pages;
+    config.num_bs_blocks = fuzz_case.num_bs_blocks;
+    config.algorithm = algorithm;
+    if (mode == ENGINE_WINDOW)
+    {
+        config.opt_window = fuzz_case.references.size();
+    }
+    else if (algorithm == Algorithm::OPT)
+    {
+        for (const Reference &reference : fuzz_case.references)
+        {
+            config.future_page_numbers.push_back(reference.address / fuzz_case.page_size);
+        }
+    }
+    VirtualMemory memory(config);
+
+    // run the references one at a time, or in one batch with the runs to the same page collapsed like tracecompress does
+    if (mode == ENGINE_SINGLE)
+    {
+        for (const Reference &reference : fuzz_case.references)
+        {
+            memory.access(reference.operation, reference.address);
+        }
+    }
+    else
+    {
+        vector<Reference> batch;
+        for (const Reference &reference : fuzz_case.references)
+        {
+            if (!batch.empty() && batch.back().operation == reference.operation && batch.back().address / fuzz_case.page_size == reference.address / fuzz_case.page_size)
+            {
+                batch.back().count++;
+            }
+            else
+            {
+                batch.push_back(reference);
+            }
+        }
+        memory.access_batch(batch);
+    }
+    memory.finish_lookahead();
+
+    // take the snapshot
+    MemorySnapshot snapshot;
+    for (const PageTableEntry &page : memory.page_table())
+    {
+        snapshot.pages.push_back({(int)page.type, page.frame_number, page.on_disk});
+    }
+    for (const FrameTableEntry &frame : memory.frame_table())
+    {
+        snapshot.frames.push_back({frame.page_number, frame.in_use, frame.dirty, frame.first_use, frame.last_use});
+    }
+    VirtualMemoryStats stats = memory.stats();
+    snapshot.counters = {stats.pages_referenced, stats.pages_mapped, stats.page_miss_instances, stats.frame_stolen_instances,
+                         stats.stolen_frames_written_to_swapspace, stats.stolen_frames_recovered_from_swapspace};
+    return snapshot;
+}
+
+// describe the first field two snapshots differ in, returns an empty string if they are the same
+string first_difference(const MemorySnapshot &expected, const MemorySnapshot &actual)
+{
+    stringstream ss;
+    for (size_t i = 0; i < expected.pages.size() && i < actual.pages.size(); ++i)
+    {
+        for (int field = 0; field < 3; ++field)
+        {
+            if (expected.pages[i][field] != actual.pages[i][field])
+            {
+                ss << "page " << i << " " << PAGE_FIELD_NAMES[field] << ": original " << expected.pages[i][field] << ", engine " << actual.pages[i][field];
+                return ss.str();
+            }
+        }
+    }
+    for (size_t i = 0; i < expected.frames.size() && i < actual.frames.size(); ++i)
+    {
+        for (int field = 0; field < 5; ++field)
+        {
+            if (expected.frames[i][field] != actual.frames[i][field])
+            {
+                ss << "frame " << i << " " << FRAME_FIELD_NAMES[field] << ": original " << expected.frames[i][field] << ", engine " << actual.frames[i][field];
+                return ss.str();
+            }
+        }
+    }
+    for (size_t i = 0; i < expected.counters.size(); ++i)
+    {
+        if (expected.counters[i] != actual.counters[i])
+        {
+            ss << COUNTER_NAMES[i] << ": original " << expected.counters[i] << ", engine " << actual.counters[i];
+            return ss.str();
+        }
+    }
+    if (expected.pages.size() != actual.pages.size() || expected.frames.size() != actual.frames.size())
+    {
+        return "table sizes differ";
+    }
+    return "";
+}
+
+// compare the engine with the original on a case, returns the first difference (empty if they agree)
+string compare(const FuzzCase &fuzz_case, Algorithm algorithm, EngineMode mode)
+{
+    try
+    {
+        return first_difference(run_baseline(fuzz_case, algorithm), run_engine(fuzz_case, algorithm, mode));
+    }
+    catch (const exception &error)
+    {
+        return string("engine stopped: ") + error.what();
+    }
+}
+
+// shrink a case the engine disagrees with the original on, by removing references, frames, and pages and turning writes
+// into reads for as long as the disagreement stays
+FuzzCase shrink(FuzzCase fuzz_case, Algorithm algorithm, EngineMode mode)
+{
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+
+        // remove chunks of references, from half the trace down to one reference at a time
+        for (size_t chunk = max<size_t>(1, fuzz_case.references.size() / 2); chunk >= 1; chunk /= 2)
+        {
+            for (size_t start = 0; start + chunk <= fuzz_case.references.size() && fuzz_case.references.size() > 1;)
+            {
+                FuzzCase smaller = fuzz_case;
+                smaller.references.erase(smaller.references.begin() + start, smaller.references.begin() + start + chunk);
+                if (!smaller.references.empty() && compare(smaller, algorithm, mode) != "")
+                {
+                    fuzz_case = smaller;
+                    changed = true;
+                }
+                else
+                {
+                    start += chunk;
+                }
+            }
+        }
+
+        // use fewer frames
+        while (fuzz_case.num_frames > 1)
+        {
+            FuzzCase smaller = fuzz_case;
+            smaller.num_frames--;
+            if (compare(smaller, algorithm, mode) == "")
+            {
+                break;
+            }
+            fuzz_case = smaller;
+            changed = true;
+        }
+
+        // turn writes into reads and move each address to the start of its page
+        for (size_t i = 0; i < fuzz_case.references.size(); ++i)
+        {
+            FuzzCase simpler = fuzz_case;
+            simpler.references[i].operation = 'r';
+            simpler.references[i].address -= simpler.references[i].address % simpler.page_size;
+            if (!(simpler.references[i].operation == fuzz_case.references[i].operation && simpler.references[i].address == fuzz_case.references[i].address)
+                && compare(simpler, algorithm, mode) != "")
+            {
+                fuzz_case = simpler;
+                changed = true;
+            }
+        }
+    }
+
+    // only keep the pages that are referenced
+    int max_page = 0;
+    for (const Reference &reference : fuzz_case.references)
+    {
+        max_page = max(max_page, reference.address / fuzz_case.page_size);
+    }
+    FuzzCase smaller = fuzz_case;
+    smaller.num_pages = max_page + 1;
+    smaller.num_bs_blocks = min(fuzz_case.num_bs_blocks, max_page + 1);
+    return compare(smaller, algorithm, mode) != "" ? smaller : fuzz_case;
+}
+
+// split a comma separated list
+vector<string> split_list(const string &value)
+{
+    vector<string> items;
+    stringstream ss(value);
+    string item;
+    while (getline(ss, item, ','))
+    {
+        items.push_back(item);
+    }
+    return items;
+}
+
+int main(int argc, char *argv[])
+{
+    // default settings, running for a number of seconds unless a number of cases is given
+    long long max_cases = 0;
+    double max_seconds = 10;
+    unsigned long long seed = 1;
+    vector<string> algorithm_names = {"FIFO", "LRU", "OPTIMAL"};
+
+    // read the flags
+    for (int arg_index = 1; arg_index < argc; arg_index += 2)
+    {
+        string flag = argv[arg_index];
+        if (arg_index + 1 >= argc)
+        {
+            cout << "Usage: " << argv[0] << " [--cases <cases>] [--seconds <seconds>] [--seed <seed>] [--algorithms <list>]" << endl;
+            return 1;
+        }
+        string value = argv[arg_index + 1];
+        if (flag == "--cases")
+        {
+            max_cases = atoll(value.c_str());
+            max_seconds = 0;
+        }
+        else if (flag == "--seconds")
+        {
+            max_seconds = atof(value.c_str());
+        }
+        else if (flag == "--seed")
+        {
+            seed = strtoull(value.c_str(), nullptr, 10);
+        }
+        else if (flag == "--algorithms")
+        {
+            algorithm_names = split_list(value);
+        }
+        else
+        {
+            cout << "Invalid argument" << endl;
+            return 1;
+        }
+    }
+
+    // check the settings
+    if (max_cases <= 0 && max_seconds <= 0)
+    {
+        cout << "Invalid number of cases or seconds" << endl;
+        return 1;
+    }
+    vector<Algorithm> algorithms;
+    for (const string &name : algorithm_names)
+    {
+        if (name == "FIFO" || name == "LRU" || name == "OPTIMAL")
+        {
+            algorithms.push_back(name == "FIFO" ? Algorithm::FIFO : name == "LRU" ? Algorithm::LRU : Algorithm::OPT);
+        }
+        else
+        {
+            cout << "Invalid algorithm: " << name << endl;
+            return 1;
+        }
+    }
+
+    // run cases until the count or the time is used up, checking every engine mode of each algorithm against the original
+    CaseGenerator generator(seed);
+    auto start = chrono::steady_clock::now();
+    long long cases = 0;
+    long long engine_runs = 0;
+    double elapsed = 0;
+    while ((max_cases > 0 && cases < max_cases) || (max_cases <= 0 && elapsed < max_seconds))
+    {
+        FuzzCase fuzz_case = generator.next_case();
+        for (size_t a = 0; a < algorithms.size(); ++a)
+        {
+            Algorithm algorithm = algorithms[a];
+            MemorySnapshot expected = run_baseline(fuzz_case, algorithm);
+            for (EngineMode mode : {ENGINE_SINGLE, ENGINE_BATCH, ENGINE_WINDOW})
+            {
+                if (mode == ENGINE_WINDOW && algorithm != Algorithm::OPT)
+                {
+                    continue;
+                }
+                engine_runs++;
+                string difference;
+                try
+                {
+                    difference = first_difference(expected, run_engine(fuzz_case, algorithm, mode));
+                }
+                catch (const exception &error)
+                {
+                    difference = string("engine stopped: ") + error.what();
+                }
+                if (difference == "")
+                {
+                    continue;
+                }
+
+                // shrink the trace and report it
+                FuzzCase minimal = shrink(fuzz_case, algorithm, mode);
+                cout << "Divergence in " << algorithm_names[a] << " (" << ENGINE_MODE_NAMES[mode] << " engine) on case " << cases + 1 << " with seed " << seed << endl;
+                cout << "  " << compare(minimal, algorithm, mode) << endl;
+                cout << "Minimal trace (" << minimal.references.size() << " references), written to " << FUZZ_FAILURE_FILENAME << ":" << endl;
+                write_trace(minimal, cout);
+                ofstream failure_file(FUZZ_FAILURE_FILENAME);
+                write_trace(minimal, failure_file);
+                return 1;
+            }
+        }
+        cases++;
+
+        // keep track of the time, and show that the run is still going
+        elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        if (cases % FUZZ_PROGRESS_INTERVAL == 0)
+        {
+            cout << "Cases: " << cases << " (" << fixed << setprecision(0) << cases / elapsed << " per second)" << endl;
+        }
+    }
+
+    // print the summary
+    cout << "Cases: " << cases << ", engine runs: " << engine_runs << ", divergences: 0" << endl;
+    cout << "Cases per hour: " << fixed << setprecision(0) << (elapsed > 0 ? cases / elapsed * 3600 : 0) << endl;
+    return 0;
+}
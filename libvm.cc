@@ -0,0 +1,1343 @@
+// the virtual memory library (libvm), with the parts of the engine that are not on the path of every reference
+#include "vm_internal.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+// default latencies used when a cost file does not set a value
+CostModel default_cost_model()
+{
+    CostModel cost;
+    cost.hit = 100;
+    cost.minor_fault = 1000;
+    cost.major_fault = 100000;
+    cost.writeback = 100000;
+    cost.tlb_miss = 50;
+    cost.tlb_entries = 64;
+    cost.migration = 2000;
+    cost.page_copy = 1000;
+    return cost;
+}
+
+// load the cost model from a file of "<event> <nanoseconds>" lines
+bool load_cost_model(const string &filename, CostModel &cost)
+{
+    // open the cost file
+    ifstream file(filename);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    // read each of the values
+    string line;
+    while (getline(file, line))
+    {
+        // ignore empty lines and comments
+        if (line.empty() || line[0] == '#')
+        {
+            continue;
+        }
+
+        // split the line into the event name and the latency
+        stringstream ss(line);
+        string name;
+        long long value;
+        if (!(ss >> name >> value) || value < 0)
+        {
+            return false;
+        }
+
+        // set the value for the event
+        if (name == "hit")
+        {
+            cost.hit = value;
+        }
+        else if (name == "minor_fault")
+        {
+            cost.minor_fault = value;
+        }
+        else if (name == "major_fault")
+        {
+            cost.major_fault = value;
+        }
+        else if (name == "writeback")
+        {
+            cost.writeback = value;
+        }
+        else if (name == "tlb_miss")
+        {
+            cost.tlb_miss = value;
+        }
+        else if (name == "tlb_entries" && value > 0 && value <= MAX_TLB_ENTRIES)
+        {
+            cost.tlb_entries = value;
+        }
+        else if (name == "migration")
+        {
+            cost.migration = value;
+        }
+        else if (name == "page_copy")
+        {
+            cost.page_copy = value;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// write the checkpoint to a temporary file, sync it, and rename it over the old checkpoint,
+// so a crash at any point leaves either the old or the new checkpoint and never half of one
+bool CheckpointWriter::write_file(const string &filename)
+{
+    string temp_filename = filename + ".tmp";
+    int fd = open(temp_filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1)
+    {
+        return false;
+    }
+    size_t written = 0;
+    while (written < data.size())
+    {
+        ssize_t result = write(fd, data.data() + written, data.size() - written);
+        if (result <= 0)
+        {
+            close(fd);
+            return false;
+        }
+        written += result;
+    }
+    if (fsync(fd) != 0 || close(fd) != 0 || rename(temp_filename.c_str(), filename.c_str()) != 0)
+    {
+        return false;
+    }
+
+    // sync the folder so the rename itself is on disk
+    size_t slash = filename.find_last_of('/');
+    string folder = slash == string::npos ? "." : filename.substr(0, slash + 1);
+    int folder_fd = open(folder.c_str(), O_RDONLY);
+    if (folder_fd != -1)
+    {
+        fsync(folder_fd);
+        close(folder_fd);
+    }
+    return true;
+}
+
+// read the whole checkpoint file and check the magic bytes
+bool CheckpointReader::read_file(const string &filename)
+{
+    ifstream file(filename, ios::binary);
+    if (!file.is_open())
+    {
+        return false;
+    }
+    stringstream ss;
+    ss << file.rdbuf();
+    data = ss.str();
+    position = 0;
+    ok = data.size() >= sizeof(CHECKPOINT_MAGIC) && equal(CHECKPOINT_MAGIC, CHECKPOINT_MAGIC + sizeof(CHECKPOINT_MAGIC), data.begin());
+    position = sizeof(CHECKPOINT_MAGIC);
+    return ok;
+}
+
+// constructor
+Profiler::Profiler()
+{
+    sampling = false;
+    lines = 0;
+    current_phase = NO_PHASE;
+    phase_start_ns = 0;
+    fill(phase_start_counters, phase_start_counters + NUM_PERF_COUNTERS, 0);
+    phase_samples.assign(NUM_PROFILE_PHASES, 0);
+    phase_ns.assign(NUM_PROFILE_PHASES, 0);
+    phase_counters.assign(NUM_PROFILE_PHASES, vector<uint64_t>(NUM_PERF_COUNTERS, 0));
+    fill(counter_fds, counter_fds + NUM_PERF_COUNTERS, -1);
+    counters_available = false;
+    counters_error = "not supported on this platform";
+    overhead_ns = 0;
+    fill(overhead_counters, overhead_counters + NUM_PERF_COUNTERS, 0);
+}
+
+// close the hardware counters
+Profiler::~Profiler()
+{
+    for (int fd : counter_fds)
+    {
+        if (fd != -1)
+        {
+            close(fd);
+        }
+    }
+}
+
+// open the hardware counters and measure the cost of reading them and the clock
+void Profiler::start()
+{
+    open_counters();
+
+    // the cost of one read is taken off every sample, so the phases only show their own work
+    const int calibration_reads = 1000;
+    uint64_t first_counters[NUM_PERF_COUNTERS] = {0, 0, 0, 0};
+    uint64_t counters[NUM_PERF_COUNTERS] = {0, 0, 0, 0};
+    long long first_ns = read_now(first_counters);
+    long long now = first_ns;
+    for (int i = 0; i < calibration_reads; ++i)
+    {
+        now = read_now(counters);
+    }
+    overhead_ns = (double)(now - first_ns) / calibration_reads;
+    for (int i = 0; i < NUM_PERF_COUNTERS; ++i)
+    {
+        overhead_counters[i] = (double)(counters[i] - first_counters[i]) / calibration_reads;
+    }
+}
+
+// open the hardware counters as one group, so they are all read together (the profile still has the times if this fails)
+void Profiler::open_counters()
+{
+#ifdef __linux__
+    const uint64_t configs[NUM_PERF_COUNTERS] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+    for (int i = 0; i < NUM_PERF_COUNTERS; ++i)
+    {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = configs[i];
+        attr.disabled = i == 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP;
+        counter_fds[i] = syscall(SYS_perf_event_open, &attr, 0, -1, i == 0 ? -1 : counter_fds[0], 0);
+        if (counter_fds[i] == -1)
+        {
+            counters_error = strerror(errno);
+            return;
+        }
+    }
+    ioctl(counter_fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    counters_available = true;
+#endif
+}
+
+// read the clock and the hardware counters
+long long Profiler::read_now(uint64_t counters[])
+{
+    if (counters_available)
+    {
+        uint64_t values[NUM_PERF_COUNTERS + 1];
+        if (read(counter_fds[0], values, sizeof(values)) == (ssize_t)sizeof(values))
+        {
+            copy(values + 1, values + 1 + NUM_PERF_COUNTERS, counters);
+        }
+    }
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// print the per-phase breakdown in the following format (the counter columns are left out if the counters are unavailable)
+/*
+Profile
+  Sampled lines: 1 in 64
+  Timer overhead per sample (ns): 21.5
+  Hardware counters: on
+  phase        samples  share%      avg_ns      cycles      instrs  cache_miss  branch_miss
+  parse          15625  21.344        52.1       150.2       310.0         0.1          0.3
+*/
+void Profiler::print(OutputBuffer &output)
+{
+    // take the overhead of reading the clock and counters off each phase
+    vector<double> average_ns(NUM_PROFILE_PHASES, 0.0);
+    double total_ns = 0;
+    for (int phase = 0; phase < NUM_PROFILE_PHASES; ++phase)
+    {
+        if (phase_samples[phase] > 0)
+        {
+            average_ns[phase] = max(0.0, (double)phase_ns[phase] / phase_samples[phase] - overhead_ns);
+            total_ns += average_ns[phase] * phase_samples[phase];
+        }
+    }
+
+    output << "Profile" << '\n';
+    output << "  Sampled lines: 1 in " << PROFILE_SAMPLE_INTERVAL << '\n';
+    output << "  Timer overhead per sample (ns): " << Fixed{overhead_ns, 1} << '\n';
+    output << "  Hardware counters: " << (counters_available ? string("on") : "unavailable (" + counters_error + ")") << '\n';
+    output << "  phase        samples  share%      avg_ns";
+    if (counters_available)
+    {
+        output << "      cycles      instrs  cache_miss  branch_miss";
+    }
+    output << '\n';
+    for (int phase = 0; phase < NUM_PROFILE_PHASES; ++phase)
+    {
+        long long samples = phase_samples[phase];
+        output << "  " << LeftAligned{PROFILE_PHASE_NAMES[phase], 11} << Padded{samples, 9};
+        output << Fixed{total_ns > 0 ? 100.0 * average_ns[phase] * samples / total_ns : 0.0, 3, 8};
+        output << Fixed{average_ns[phase], 1, 12};
+
+        // the counters are averaged over the samples of the phase
+        if (counters_available)
+        {
+            for (int i = 0; i < NUM_PERF_COUNTERS; ++i)
+            {
+                double average = samples > 0 ? max(0.0, (double)phase_counters[phase][i] / samples - overhead_counters[i]) : 0.0;
+                output << Fixed{average, 1, i == NUM_PERF_COUNTERS - 1 ? 13 : 12};
+            }
+        }
+        output << '\n';
+    }
+}
+
+// get the value of a hex digit (-1 if the character is not a hex digit)
+int hex_digit_value(char c)
+{
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f')
+    {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F')
+    {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+// parse the operation and the address at the start of a reference line, end is set to where the address stops
+bool parse_address(const string &line, char &operation, int &address, size_t &end)
+{
+    // the operation is the first character
+    operation = line[0];
+
+    // skip the spaces and an optional 0x before the address
+    size_t i = 1;
+    while (i < line.size() && (line[i] == ' ' || line[i] == '\t'))
+    {
+        i++;
+    }
+    if (i + 2 < line.size() && line[i] == '0' && (line[i + 1] == 'x' || line[i + 1] == 'X') && hex_digit_value(line[i + 2]) != -1)
+    {
+        i += 2;
+    }
+
+    // read the hex digits of the address
+    long long value = 0;
+    size_t first_digit = i;
+    for (; i < line.size() && hex_digit_value(line[i]) != -1; ++i)
+    {
+        value = value * 16 + hex_digit_value(line[i]);
+        if (value > INT_MAX)
+        {
+            return false;
+        }
+    }
+    address = value;
+    end = i;
+    return i > first_digit;
+}
+
+// parse the repeat count that may follow the address at i, the count is 1 if there is none, returns false if it is not
+// positive
+bool parse_count(const string &line, size_t i, int &count)
+{
+    // skip the spaces before the count
+    while (i < line.size() && (line[i] == ' ' || line[i] == '\t'))
+    {
+        i++;
+    }
+
+    // read the decimal digits of the count
+    long long value = 0;
+    size_t first_digit = i;
+    for (; i < line.size() && line[i] >= '0' && line[i] <= '9'; ++i)
+    {
+        value = value * 10 + (line[i] - '0');
+        if (value > INT_MAX)
+        {
+            return false;
+        }
+    }
+    count = i > first_digit ? value : 1;
+    return count > 0;
+}
+
+// parse a reference line ("r 1f" or "w 0x1f") into the operation and the address, returns false if there is no valid address
+bool parse_reference(const string &line, char &operation, int &address)
+{
+    size_t end;
+    return parse_address(line, operation, address, end);
+}
+
+// parse a reference line that may have a repeat count after the address ("r 1f 12"), the count is 1 if there is none,
+// returns false if there is no valid address or the count is not positive
+bool parse_reference(const string &line, char &operation, int &address, int &count)
+{
+    size_t end;
+    return parse_address(line, operation, address, end) && parse_count(line, end, count);
+}
+
+// parse a reference line with a repeat count, also giving the text of the address as it is in the line
+bool parse_reference(const string &line, char &operation, int &address, int &count, string &address_text)
+{
+    size_t end;
+    if (!parse_address(line, operation, address, end))
+    {
+        return false;
+    }
+    address_text = line.substr(1, end - 1);
+    return parse_count(line, end, count);
+}
+
+// constructor
+VirtualMemoryEngine::VirtualMemoryEngine(int ps, int nf, int np, int nbb, Algorithm algo)
+{
+    page_size = ps;
+    num_frames = nf;
+    num_pages = np;
+    num_bs_blocks = nbb;
+    algorithm = algo;
+    pages_referenced = 0;
+    pages_mapped = 0;
+    page_miss_instances = 0;
+    frame_stolen_instances = 0;
+    stolen_frames_written_to_swapspace = 0;
+    stolen_frames_recovered_from_swapspace = 0;
+    fifo_policy = FifoPolicy(algorithm == Algorithm::FIFO ? num_frames : 0);
+    lru_policy = LruPolicy(algorithm == Algorithm::LRU ? num_frames : 0);
+    opt_policy = OptPolicy(algorithm == Algorithm::OPT ? num_frames : 0);
+    next_empty_frame = 0;
+    opt_window = 0;
+    lookahead_handler = nullptr;
+    profiler = nullptr;
+    set_debug(nullptr);
+    show_backing_store = false;
+    last_bs_block = -1;
+    swap_seek_distance = 0;
+    swap_sequential_ios = 0;
+    swap_overflows = 0;
+    prefetch_policy = NO_PREFETCH;
+    prefetch_depth = 0;
+    last_stream_page = -1;
+    last_stream_stride = 0;
+    pages_prefetched = 0;
+    prefetched_pages_used = 0;
+    prefetched_pages_evicted_unused = 0;
+    stats_out = nullptr;
+    stats_every = 0;
+    stats_interval_ms = 0;
+    stats_json = false;
+    stats_last_references = 0;
+    stats_last_misses = 0;
+    cost_enabled = false;
+    cost = default_cost_model();
+    tlb_misses = 0;
+    estimated_time = 0;
+    flusher_enabled = false;
+    flusher_high_watermark = 0;
+    flusher_low_watermark = 0;
+    flusher_interval = 1;
+    frames_cleaned_by_flusher = 0;
+    num_dirty_frames = 0;
+    prefer_clean = false;
+    tiers_enabled = false;
+    tier_placement = PLACE_FASTEST;
+    promote_after = 0;
+    process_pids.assign(1, 0);
+    current_process = 0;
+    page_base = 0;
+    processes_forked = 0;
+    processes_exited = 0;
+    cow_faults = 0;
+    frames_saved = 0;
+    peak_frames_saved = 0;
+
+    // initialize the pages and frames
+    pages.resize(num_pages);
+    frames.resize(num_frames);
+    backing_store.resize(num_bs_blocks, BackingStoreBlock{0, -1, 0, 0}); // initialize backing store with every block empty
+    swap_allocator = SwapAllocator(num_bs_blocks);
+
+    // initialize the pages
+    for (int i = 0; i < num_pages; ++i)
+    {
+        pages[i].page_number = i;
+        pages[i].type = UNUSED;
+        pages[i].frame_number = -1;
+        pages[i].on_disk = 0; // assuming all pages are on disk for simplicity
+        pages[i].bs_block = -1;
+    }
+
+    // initialize the frames
+    for (int i = 0; i < num_frames; ++i)
+    {
+        frames[i].frame_number = i;
+        frames[i].page_number = -1;
+        frames[i].first_use = -1;
+        frames[i].last_use = -1;
+        frames[i].dirty = 0;
+        frames[i].in_use = 0;
+        frames[i].prefetched = 0;
+    }
+}
+
+// constructor with all of the settings of the simulation
+VirtualMemoryEngine::VirtualMemoryEngine(const VirtualMemoryConfig &config) : VirtualMemoryEngine(config.page_size, config.num_frames, config.num_pages, config.num_bs_blocks, config.algorithm)
+{
+    show_backing_store = config.show_backing_store;
+    prefer_clean = config.prefer_clean;
+    set_swap_cluster_size(config.swap_cluster_size);
+    enable_prefetch(config.prefetch_policy, config.prefetch_depth);
+    if (config.flusher_enabled)
+    {
+        enable_flusher(config.flusher_high_watermark, config.flusher_low_watermark, config.flusher_interval);
+    }
+    if (config.cost_enabled)
+    {
+        enable_cost_model(config.cost);
+    }
+    if (!config.tiers.empty())
+    {
+        enable_tiers(config.tiers, config.tier_placement, config.promote_after);
+    }
+    if (algorithm == Algorithm::OPT && config.opt_window > 0)
+    {
+        set_opt_window(config.opt_window);
+    }
+    else if (algorithm == Algorithm::OPT)
+    {
+        set_future_references(config.future_page_numbers);
+    }
+}
+
+// get the counters of the run so far
+VirtualMemoryStats VirtualMemoryEngine::stats() const
+{
+    VirtualMemoryStats result;
+    result.pages_referenced = pages_referenced;
+    result.pages_mapped = pages_mapped;
+    result.page_miss_instances = page_miss_instances;
+    result.frame_stolen_instances = frame_stolen_instances;
+    result.stolen_frames_written_to_swapspace = stolen_frames_written_to_swapspace;
+    result.stolen_frames_recovered_from_swapspace = stolen_frames_recovered_from_swapspace;
+    result.frames_cleaned_by_flusher = frames_cleaned_by_flusher;
+    result.pages_prefetched = pages_prefetched;
+    result.prefetched_pages_used = prefetched_pages_used;
+    result.prefetched_pages_evicted_unused = prefetched_pages_evicted_unused;
+    result.tlb_misses = tlb_misses;
+    result.estimated_time = estimated_time;
+    result.cow_faults = cow_faults;
+    result.swap_overflows = swap_overflows;
+    result.processes_forked = processes_forked;
+    return result;
+}
+// write the tables, counters, and policy state to a checkpoint (the settings from the command line are not saved,
+// they are given again when the run is resumed)
+void VirtualMemoryEngine::save(CheckpointWriter &writer)
+{
+    // tables
+    writer.put_vector(frames);
+    writer.put_vector(pages);
+    writer.put_vector(backing_store);
+    swap_allocator.save(writer);
+
+    // processes
+    writer.put_vector(process_pids);
+    writer.put(current_process);
+    writer.put(page_base);
+    writer.put(processes_forked);
+    writer.put(processes_exited);
+    writer.put(cow_faults);
+    writer.put(frames_saved);
+    writer.put(peak_frames_saved);
+
+    // counters
+    writer.put(pages_referenced);
+    writer.put(pages_mapped);
+    writer.put(page_miss_instances);
+    writer.put(frame_stolen_instances);
+    writer.put(stolen_frames_written_to_swapspace);
+    writer.put(stolen_frames_recovered_from_swapspace);
+
+    // replacement policy
+    fifo_policy.save(writer);
+    lru_policy.save(writer);
+    opt_policy.save(writer);
+    writer.put(next_empty_frame);
+    vector<Reference> held_back;
+    for (size_t i = 0; i < lookahead.size(); ++i)
+    {
+        held_back.push_back(lookahead[i]);
+    }
+    writer.put_vector(held_back);
+
+    // swap I/O, prefetch, streaming statistics, cost model, and writeback
+    writer.put(last_bs_block);
+    writer.put(swap_seek_distance);
+    writer.put(swap_sequential_ios);
+    writer.put(swap_overflows);
+    writer.put(last_stream_page);
+    writer.put(last_stream_stride);
+    writer.put(pages_prefetched);
+    writer.put(prefetched_pages_used);
+    writer.put(prefetched_pages_evicted_unused);
+    writer.put(stats_last_references);
+    writer.put(stats_last_misses);
+    tlb.save(writer);
+    writer.put(tlb_misses);
+    writer.put(estimated_time);
+    writer.put_vector(latency_histogram);
+    writer.put(frames_cleaned_by_flusher);
+
+    // memory tiers
+    writer.put_vector(tiers);
+    writer.put_vector(frame_tier_hits);
+    for (FrameList &recency : tier_recency)
+    {
+        recency.save(writer);
+    }
+}
+
+// read the state written by save back into a virtual memory with the same sizes and settings, returns false if the
+// checkpoint is cut short or does not fit
+bool VirtualMemoryEngine::load(CheckpointReader &reader)
+{
+    // tables
+    reader.get_vector(frames);
+    reader.get_vector(pages);
+    reader.get_vector(backing_store);
+    swap_allocator.load(reader);
+    num_dirty_frames = 0;
+    for (const Frame &frame : frames)
+    {
+        num_dirty_frames += frame.dirty;
+    }
+
+    // processes, which windowed OPT needs room for before it is read
+    reader.get_vector(process_pids);
+    reader.get(current_process);
+    reader.get(page_base);
+    reader.get(processes_forked);
+    reader.get(processes_exited);
+    reader.get(cow_faults);
+    reader.get(frames_saved);
+    reader.get(peak_frames_saved);
+    if (opt_window > 0)
+    {
+        opt_policy.add_pages(pages.size());
+    }
+
+    // counters
+    reader.get(pages_referenced);
+    reader.get(pages_mapped);
+    reader.get(page_miss_instances);
+    reader.get(frame_stolen_instances);
+    reader.get(stolen_frames_written_to_swapspace);
+    reader.get(stolen_frames_recovered_from_swapspace);
+
+    // replacement policy
+    fifo_policy.load(reader);
+    lru_policy.load(reader);
+    opt_policy.load(reader);
+    reader.get(next_empty_frame);
+
+    // the references held back for windowed OPT are added to the window again
+    vector<Reference> held_back;
+    reader.get_vector(held_back);
+    bool held_back_fits = held_back.size() <= lookahead.items.size();
+    for (size_t i = 0; held_back_fits && i < held_back.size(); ++i)
+    {
+        long long index = pages_referenced + (long long)lookahead.size();
+        lookahead.push_back(held_back[i]);
+        opt_policy.add_to_window(held_back[i].address / page_size + page_base, pages_referenced, index);
+    }
+
+    // swap I/O, prefetch, streaming statistics, cost model, and writeback
+    size_t tlb_entries = tlb.entry_page.size();
+    size_t latency_buckets = latency_histogram.size();
+    reader.get(last_bs_block);
+    reader.get(swap_seek_distance);
+    reader.get(swap_sequential_ios);
+    reader.get(swap_overflows);
+    reader.get(last_stream_page);
+    reader.get(last_stream_stride);
+    reader.get(pages_prefetched);
+    reader.get(prefetched_pages_used);
+    reader.get(prefetched_pages_evicted_unused);
+    reader.get(stats_last_references);
+    reader.get(stats_last_misses);
+    tlb.load(reader);
+    reader.get(tlb_misses);
+    reader.get(estimated_time);
+    reader.get_vector(latency_histogram);
+    reader.get(frames_cleaned_by_flusher);
+
+    // memory tiers
+    size_t num_tiers = tiers.size();
+    reader.get_vector(tiers);
+    reader.get_vector(frame_tier_hits);
+    for (FrameList &recency : tier_recency)
+    {
+        recency.load(reader);
+    }
+
+    // the tables have to have the sizes the virtual memory was created with
+    return reader.ok && held_back_fits && (int)frames.size() == num_frames && pages.size() == (size_t)num_pages * process_pids.size() && (int)backing_store.size() == num_bs_blocks
+        && swap_allocator.num_blocks == num_bs_blocks && tlb.entry_page.size() == tlb_entries && tlb.recency.prev.size() == tlb_entries && latency_histogram.size() == latency_buckets
+        && tiers.size() == num_tiers && frame_tier_hits.size() == (tiers_enabled ? (size_t)num_frames : 0);
+}
+
+// function to print the memory state to the output
+void VirtualMemoryEngine::print_memory_state(OutputBuffer &output)
+{
+    // print the page table in the following format
+    /*
+    Page Table
+        0 type:STOLEN framenum:-1 ondisk:0
+        1 type:UNUSED
+        2 type:MAPPED framenum:3 ondisk:0
+    */
+    // once a process has forked, each running process has its own page table with its pid after the title
+    for (size_t process = 0; process < process_pids.size(); ++process)
+    {
+        if (process_pids[process] == -1)
+        {
+            continue;
+        }
+        output << "Page Table";
+        if (processes_forked > 0)
+        {
+            output << " (process " << process_pids[process] << ")";
+        }
+        output << '\n';
+        for (int i = 0; i < num_pages; ++i)
+        {
+            const Page &page = pages[process * num_pages + i];
+            if (page.type == PageType::UNUSED)
+            {
+                output << Padded{(long long)i, 5} << " type:UNUSED" << '\n';
+            }
+            else
+            {
+                output << Padded{(long long)i, 5} << " ";
+                if (page.type == PageType::STOLEN)
+                {
+                    output << "type:STOLEN ";
+                }
+                else
+                {
+                    output << "type:MAPPED ";
+                }
+                output << "framenum:" << page.frame_number << " ondisk:" << page.on_disk;
+                if (show_backing_store && page.bs_block != -1)
+                {
+                    output << " bsblock:" << page.bs_block;
+                }
+                output << '\n';
+            }
+        }
+    }
+
+    // print the frame table in the following format
+    /*
+    Frame Table
+        0 inuse:0
+        1 inuse:1 dirty:0 firstuse:1 lastuse:1
+        2 inuse:1 dirty:1 firstuse:2 lastuse:2
+    */
+    output << "Frame Table" << '\n';
+    for (size_t i = 0; i < frames.size(); ++i)
+    {
+        output << Padded{(long long)i, 5} <<  " ";
+        if (frames[i].in_use == 0)
+        {
+            output << "inuse:0" << '\n';
+        }
+        else
+        {
+            output << "inuse:" << frames[i].in_use << " dirty:" << frames[i].dirty << " first_use:" << frames[i].first_use << " last_use:" << frames[i].last_use << '\n';
+        }
+    }
+
+    // print the backing store table in the following format
+    /*
+    Backing Store Table
+        0 inuse:1 page:2 reads:1 writes:1
+        1 inuse:0
+      TTL BS blocks inuse: 1
+      TTL BS blocks read: 1
+      TTL BS blocks written: 1
+    */
+    if (show_backing_store)
+    {
+        int blocks_in_use = 0;
+        long long blocks_read = 0;
+        long long blocks_written = 0;
+        output << "Backing Store Table" << '\n';
+        for (size_t i = 0; i < backing_store.size(); ++i)
+        {
+            output << Padded{(long long)i, 5} << " ";
+            if (backing_store[i].in_use == 0)
+            {
+                output << "inuse:0" << '\n';
+            }
+            else
+            {
+                output << "inuse:" << backing_store[i].in_use << " page:" << backing_store[i].page_number % num_pages << " reads:" << backing_store[i].reads << " writes:" << backing_store[i].writes << '\n';
+                blocks_in_use++;
+            }
+            blocks_read += backing_store[i].reads;
+            blocks_written += backing_store[i].writes;
+        }
+        output << "  TTL BS blocks inuse: " << blocks_in_use << '\n';
+        output << "  TTL BS blocks read: " << blocks_read << '\n';
+        output << "  TTL BS blocks written: " << blocks_written << '\n';
+    }
+
+    // print the statistics
+    output << "Pages referenced: " << pages_referenced << '\n';
+    output << "Pages mapped: " << pages_mapped << '\n';
+    output << "Page miss instances: " << page_miss_instances << '\n';
+    output << "Frame stolen instances: " << frame_stolen_instances << '\n';
+    output << "Stolen frames written to swapspace: " << stolen_frames_written_to_swapspace << '\n';
+    output << "Stolen frames recovered from swapspace: " << stolen_frames_recovered_from_swapspace << '\n';
+
+    // print the flusher statistics if the flusher is on
+    if (flusher_enabled)
+    {
+        output << "Frames cleaned by flusher: " << frames_cleaned_by_flusher << '\n';
+    }
+}
+
+// turn on the streaming statistics, written every so many references and/or milliseconds
+void VirtualMemoryEngine::enable_stats_stream(ostream *out, int every, int interval_ms, bool json)
+{
+    stats_out = out;
+    stats_every = every;
+    stats_interval_ms = interval_ms;
+    stats_json = json;
+    stats_start = chrono::steady_clock::now();
+    stats_last_time = stats_start;
+
+    // write the column names for csv
+    if (!stats_json)
+    {
+        *stats_out << "references,elapsed_ms,page_misses,interval_miss_rate,pages_mapped,frames_stolen,written_to_swapspace,recovered_from_swapspace,cleaned_by_flusher,pages_prefetched,estimated_time_ns\n";
+    }
+}
+
+// write one line of the streaming statistics (only the counters, never the tables)
+void VirtualMemoryEngine::write_stats_line()
+{
+    // get the time since the start and the miss rate since the last line
+    auto now = chrono::steady_clock::now();
+    long long elapsed_ms = chrono::duration_cast<chrono::milliseconds>(now - stats_start).count();
+    long long interval_references = pages_referenced - stats_last_references;
+    double interval_miss_rate = interval_references > 0 ? (double)(page_miss_instances - stats_last_misses) / interval_references : 0.0;
+
+    // write the counters as csv or json
+    if (stats_json)
+    {
+        *stats_out << "{\"references\":" << pages_referenced << ",\"elapsed_ms\":" << elapsed_ms
+                   << ",\"page_misses\":" << page_miss_instances << ",\"interval_miss_rate\":" << interval_miss_rate
+                   << ",\"pages_mapped\":" << pages_mapped << ",\"frames_stolen\":" << frame_stolen_instances
+                   << ",\"written_to_swapspace\":" << stolen_frames_written_to_swapspace
+                   << ",\"recovered_from_swapspace\":" << stolen_frames_recovered_from_swapspace
+                   << ",\"cleaned_by_flusher\":" << frames_cleaned_by_flusher << ",\"pages_prefetched\":" << pages_prefetched
+                   << ",\"estimated_time_ns\":" << estimated_time << "}\n";
+    }
+    else
+    {
+        *stats_out << pages_referenced << "," << elapsed_ms << "," << page_miss_instances << "," << interval_miss_rate << ","
+                   << pages_mapped << "," << frame_stolen_instances << "," << stolen_frames_written_to_swapspace << ","
+                   << stolen_frames_recovered_from_swapspace << "," << frames_cleaned_by_flusher << "," << pages_prefetched << ","
+                   << estimated_time << "\n";
+    }
+
+    // remember where this line left off
+    stats_last_references = pages_referenced;
+    stats_last_misses = page_miss_instances;
+    stats_last_time = now;
+
+    // flush every line so a reader following the file sees it while the trace is still running
+    stats_out->flush();
+}
+
+// write the last line of the streaming statistics at the end of the trace
+void VirtualMemoryEngine::finish_stats_stream()
+{
+    if (stats_out != nullptr)
+    {
+        if (pages_referenced != stats_last_references)
+        {
+            write_stats_line();
+        }
+        stats_out->flush();
+    }
+}
+
+// set the number of blocks in each swap cluster
+void VirtualMemoryEngine::set_swap_cluster_size(int cluster_size)
+{
+    swap_allocator = SwapAllocator(num_bs_blocks, cluster_size);
+}
+
+// function to print the backing store I/O locality
+void VirtualMemoryEngine::print_swap_stats(OutputBuffer &output)
+{
+    // print the swap I/O in the following format
+    /*
+    Swap I/O
+      Blocks free: 6
+      Cluster size: 32
+      Average seek distance (blocks): 1.500
+      Sequential I/Os: 3
+      Overflows: 0
+    */
+    long long ios = 0;
+    for (auto &block : backing_store)
+    {
+        ios += block.reads + block.writes;
+    }
+    output << "Swap I/O" << '\n';
+    output << "  Blocks free: " << swap_allocator.free_blocks << '\n';
+    output << "  Cluster size: " << swap_allocator.cluster_size << '\n';
+    output << "  Average seek distance (blocks): " << Fixed{ios > 1 ? (double)swap_seek_distance / (ios - 1) : 0.0, 3} << '\n';
+    output << "  Sequential I/Os: " << swap_sequential_ios << '\n';
+    output << "  Overflows: " << swap_overflows << '\n';
+}
+
+// turn on a prefetch policy that brings in up to depth pages on each miss
+void VirtualMemoryEngine::enable_prefetch(PrefetchPolicy policy, int depth)
+{
+    prefetch_policy = policy;
+    prefetch_depth = depth;
+    prefetch_candidates.reserve(depth);
+}
+
+// function to print how well the prefetcher did
+void VirtualMemoryEngine::print_prefetch_stats(OutputBuffer &output)
+{
+    // print the prefetch statistics in the following format
+    /*
+    Prefetch
+      Pages prefetched: 10
+      Prefetched pages used: 8
+      Prefetched pages evicted unused: 2
+      Accuracy: 80.000%
+      Coverage: 50.000%
+    */
+    long long demand_misses = page_miss_instances;
+    output << "Prefetch" << '\n';
+    output << "  Pages prefetched: " << pages_prefetched << '\n';
+    output << "  Prefetched pages used: " << prefetched_pages_used << '\n';
+    output << "  Prefetched pages evicted unused: " << prefetched_pages_evicted_unused << '\n';
+    output << "  Accuracy: " << Fixed{pages_prefetched > 0 ? 100.0 * prefetched_pages_used / pages_prefetched : 0.0, 3} << "%" << '\n';
+    output << "  Coverage: " << Fixed{prefetched_pages_used + demand_misses > 0 ? 100.0 * prefetched_pages_used / (prefetched_pages_used + demand_misses) : 0.0, 3} << "%" << '\n';
+}
+
+// split the frames into tiers of memory, fastest first, with the placement and promotion policies between them
+void VirtualMemoryEngine::enable_tiers(const vector<TierConfig> &tier_configs, TierPlacement placement, int promote_hits)
+{
+    // the tiers have to cover every frame
+    int total_frames = 0;
+    for (const TierConfig &tier_config : tier_configs)
+    {
+        total_frames += tier_config.num_frames;
+    }
+    if (total_frames != num_frames)
+    {
+        throw runtime_error("Tier frames do not add up to the number of frames");
+    }
+
+    // give each tier the frames after the tier before it
+    tiers_enabled = true;
+    tier_placement = placement;
+    promote_after = promote_hits;
+    tiers.clear();
+    tier_names.clear();
+    frame_tier.clear();
+    for (const TierConfig &tier_config : tier_configs)
+    {
+        tiers.push_back(Tier{(int)frame_tier.size(), tier_config.num_frames, tier_config.latency, 0, 0, 0, 0});
+        tier_names.push_back(tier_config.name);
+        frame_tier.insert(frame_tier.end(), tier_config.num_frames, (int)tiers.size() - 1);
+    }
+    frame_tier_hits.assign(num_frames, 0);
+    tier_recency.assign(tiers.size(), FrameList(num_frames));
+}
+
+// function to print the hits and page moves of each tier
+void VirtualMemoryEngine::print_tier_stats(OutputBuffer &output)
+{
+    // print the tiers in the following format
+    /*
+    Tiers
+      dram: frames 2, latency 80 ns, hits 5, fills 4, promotions 1, demotions 0
+      cxl: frames 4, latency 250 ns, hits 3, fills 0, promotions 0, demotions 3
+    */
+    output << "Tiers" << '\n';
+    for (size_t i = 0; i < tiers.size(); ++i)
+    {
+        output << "  " << tier_names[i] << ": frames " << tiers[i].num_frames << ", latency " << tiers[i].latency << " ns, hits " << tiers[i].hits
+            << ", fills " << tiers[i].fills << ", promotions " << tiers[i].promotions << ", demotions " << tiers[i].demotions << '\n';
+    }
+}
+
+// find the process with a pid, returns -1 if there is no such process running
+int VirtualMemoryEngine::find_process(int pid)
+{
+    for (size_t process = 0; process < process_pids.size(); ++process)
+    {
+        if (process_pids[process] == pid && pid != -1)
+        {
+            return process;
+        }
+    }
+    return -1;
+}
+
+// the running process forks a child with the given pid, which shares every frame and backing store block of its
+// parent until one of them writes to the page
+void VirtualMemoryEngine::fork_process(int child_pid)
+{
+    // the references before the fork run first
+    finish_lookahead();
+    if (current_process == -1)
+    {
+        throw runtime_error("No process is running");
+    }
+    if (child_pid < 0 || find_process(child_pid) != -1)
+    {
+        throw runtime_error("Process " + to_string(child_pid) + " is already running");
+    }
+
+    // the child gets a copy of the page table of its parent, after the pages of the processes before it
+    int child = process_pids.size();
+    process_pids.push_back(child_pid);
+    pages.resize(pages.size() + num_pages);
+    for (int i = 0; i < num_pages; ++i)
+    {
+        Page &page = pages[child * num_pages + i];
+        page = pages[page_base + i];
+        page.page_number = child * num_pages + i;
+
+        // the child has its own copy of each page its parent uses
+        if (page.type != UNUSED)
+        {
+            pages_mapped++;
+        }
+
+        // the frame and backing store block of the page are shared with the parent
+        if (page.type == MAPPED)
+        {
+            frames[page.frame_number].in_use++;
+            frames_saved++;
+        }
+        if (page.bs_block != -1)
+        {
+            backing_store[page.bs_block].in_use++;
+        }
+    }
+    peak_frames_saved = max(peak_frames_saved, frames_saved);
+    processes_forked++;
+
+    // windowed OPT keeps track of where each page is
+    if (opt_window > 0)
+    {
+        opt_policy.add_pages(pages.size());
+    }
+}
+
+// run the references that come after this with the pages of another process
+void VirtualMemoryEngine::switch_process(int pid)
+{
+    finish_lookahead();
+    int process = find_process(pid);
+    if (process == -1)
+    {
+        throw runtime_error("Process " + to_string(pid) + " is not running");
+    }
+    current_process = process;
+    page_base = process * num_pages;
+}
+
+// a process exits, its frames and backing store blocks are freed once no other process shares them
+void VirtualMemoryEngine::exit_process(int pid)
+{
+    finish_lookahead();
+    int process = find_process(pid);
+    if (process == -1)
+    {
+        throw runtime_error("Process " + to_string(pid) + " is not running");
+    }
+
+    // free the pages with the replacement policy of the algorithm
+    if (algorithm == Algorithm::FIFO)
+    {
+        release_process_pages(fifo_policy, process);
+    }
+    else if (algorithm == Algorithm::LRU)
+    {
+        release_process_pages(lru_policy, process);
+    }
+    else
+    {
+        release_process_pages(opt_policy, process);
+    }
+    process_pids[process] = -1;
+    processes_exited++;
+
+    // references cannot run until another process is switched to
+    if (process == current_process)
+    {
+        current_process = -1;
+    }
+}
+
+// function to print the forks, copy-on-write faults, and sharing of the processes
+void VirtualMemoryEngine::print_process_stats(OutputBuffer &output)
+{
+    // count the frames shared by more than one process
+    int shared_frames = 0;
+    for (const Frame &frame : frames)
+    {
+        if (frame.in_use > 1)
+        {
+            shared_frames++;
+        }
+    }
+
+    // print the processes in the following format
+    /*
+    Processes
+      forks: 2, exits: 1, running: 2
+      demand faults: 12, copy-on-write faults: 3
+      shared frames: 4, frames saved by sharing: 5, peak frames saved: 8
+    */
+    output << "Processes" << '\n';
+    output << "  forks: " << processes_forked << ", exits: " << processes_exited << ", running: " << (int)process_pids.size() - processes_exited << '\n';
+    output << "  demand faults: " << page_miss_instances << ", copy-on-write faults: " << cow_faults << '\n';
+    output << "  shared frames: " << shared_frames << ", frames saved by sharing: " << frames_saved << ", peak frames saved: " << peak_frames_saved << '\n';
+}
+
+// turn on the background flusher with watermarks given as a percent of the frames
+void VirtualMemoryEngine::enable_flusher(int high_percent, int low_percent, int interval)
+{
+    flusher_enabled = true;
+    flusher_high_watermark = high_percent;
+    flusher_low_watermark = low_percent;
+    flusher_interval = interval;
+}
+
+// turn on the cost model with the given latencies
+void VirtualMemoryEngine::enable_cost_model(const CostModel &cost_model)
+{
+    cost_enabled = true;
+    cost = cost_model;
+    tlb.resize(cost.tlb_entries);
+    latency_histogram.assign(LATENCY_BUCKETS, 0);
+}
+
+// function to print the estimated execution time from the cost model
+void VirtualMemoryEngine::print_cost_summary(OutputBuffer &output)
+{
+    // print the estimated times in the following format
+    /*
+    Cost Model
+      TLB misses: 3
+      Estimated total time (us): 1201.350
+      Effective access time (ns): 80090.000
+    Latency Histogram
+       <= 128 ns: 12
+    */
+    output << "Cost Model" << '\n';
+    output << "  TLB misses: " << tlb_misses << '\n';
+    output << "  Estimated total time (us): " << Fixed{estimated_time / 1000.0, 3} << '\n';
+    output << "  Effective access time (ns): " << Fixed{pages_referenced > 0 ? (double)estimated_time / pages_referenced : 0.0, 3} << '\n';
+    output << "Latency Histogram" << '\n';
+    for (int i = 0; i < LATENCY_BUCKETS; ++i)
+    {
+        if (latency_histogram[i] > 0)
+        {
+            output << "  <= " << Padded{1LL << i, 10} << " ns: " << latency_histogram[i] << '\n';
+        }
+    }
+}
+
+// constructor with all of the settings of the simulation
+VirtualMemory::VirtualMemory(const VirtualMemoryConfig &config) : engine(make_unique<VirtualMemoryEngine>(config))
+{
+}
+
+// move constructor, move assignment, and destructor (defined here, where the engine is a complete type)
+VirtualMemory::VirtualMemory(VirtualMemory &&other) = default;
+VirtualMemory &VirtualMemory::operator=(VirtualMemory &&other) = default;
+VirtualMemory::~VirtualMemory() = default;
+
+// run one reference
+void VirtualMemory::access(char operation, int address)
+{
+    engine->access(operation, address);
+}
+
+// run a reference repeated count times in a row
+void VirtualMemory::access(char operation, int address, int count)
+{
+    engine->access(operation, address, count);
+}
+
+// run a batch of references
+void VirtualMemory::access_batch(const Reference *references, size_t count)
+{
+    engine->access_batch(references, count);
+}
+
+// run a batch of references held in a vector
+void VirtualMemory::access_batch(const vector<Reference> &references)
+{
+    engine->access_batch(references.data(), references.size());
+}
+
+// run the references held back for windowed OPT
+void VirtualMemory::finish_lookahead()
+{
+    engine->finish_lookahead();
+}
+
+// fork the running process
+void VirtualMemory::fork_process(int child_pid)
+{
+    engine->fork_process(child_pid);
+}
+
+// run the references that follow in another process
+void VirtualMemory::switch_process(int pid)
+{
+    engine->switch_process(pid);
+}
+
+// end a process
+void VirtualMemory::exit_process(int pid)
+{
+    engine->exit_process(pid);
+}
+
+// get the counters of the run so far
+VirtualMemoryStats VirtualMemory::stats() const
+{
+    return engine->stats();
+}
+
+// copy out the page table
+vector<PageTableEntry> VirtualMemory::page_table() const
+{
+    vector<PageTableEntry> table(engine->pages.size());
+    for (size_t i = 0; i < engine->pages.size(); ++i)
+    {
+        table[i].type = engine->pages[i].type;
+        table[i].frame_number = engine->pages[i].frame_number;
+        table[i].on_disk = engine->pages[i].on_disk;
+    }
+    return table;
+}
+
+// copy out the frame table (a frame no page is in has page number -1)
+vector<FrameTableEntry> VirtualMemory::frame_table() const
+{
+    vector<FrameTableEntry> table(engine->frames.size());
+    for (size_t i = 0; i < engine->frames.size(); ++i)
+    {
+        const Frame &frame = engine->frames[i];
+        table[i].page_number = frame.in_use > 0 ? frame.page_number : -1;
+        table[i].in_use = frame.in_use;
+        table[i].dirty = frame.dirty;
+        table[i].first_use = frame.first_use;
+        table[i].last_use = frame.last_use;
+    }
+    return table;
+}
+
+// print the debug messages to output, or stop if output is null
+void VirtualMemory::set_debug(OutputBuffer *output)
+{
+    engine->set_debug(output);
+}
+
+// time the phases of each reference with the profiler
+void VirtualMemory::enable_profiling(Profiler &profiler)
+{
+    engine->enable_profiling(profiler);
+}
+
+// turn on the streaming statistics
+void VirtualMemory::enable_stats_stream(ostream *output, int every, int interval_ms, bool json)
+{
+    engine->enable_stats_stream(output, every, interval_ms, json);
+}
+
+// write the last line of the streaming statistics
+void VirtualMemory::finish_stats_stream()
+{
+    engine->finish_stats_stream();
+}
+
+// print the page table, frame table, (backing store table,) and counters
+void VirtualMemory::print_memory_state(OutputBuffer &output)
+{
+    engine->print_memory_state(output);
+}
+
+// print the backing store I/O locality
+void VirtualMemory::print_swap_stats(OutputBuffer &output)
+{
+    engine->print_swap_stats(output);
+}
+
+// print how well the prefetcher did
+void VirtualMemory::print_prefetch_stats(OutputBuffer &output)
+{
+    engine->print_prefetch_stats(output);
+}
+
+// print the sharing between processes
+void VirtualMemory::print_process_stats(OutputBuffer &output)
+{
+    engine->print_process_stats(output);
+}
+
+// print the hits, fills, promotions, and demotions of each tier
+void VirtualMemory::print_tier_stats(OutputBuffer &output)
+{
+    engine->print_tier_stats(output);
+}
+
+// print the estimated execution time and latency histogram
+void VirtualMemory::print_cost_summary(OutputBuffer &output)
+{
+    engine->print_cost_summary(output);
+}
+
+// write the state to a checkpoint
+void VirtualMemory::save(CheckpointWriter &writer)
+{
+    engine->save(writer);
+}
+
+// read the state written by save back in
+bool VirtualMemory::load(CheckpointReader &reader)
+{
+    return engine->load(reader);
+}
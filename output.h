@@ -0,0 +1,198 @@
+// header for the buffered output used by the vm program and the printing functions of the virtual memory library
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+// include the necessary libraries
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// size of the output buffer, output is only written out when the buffer fills up or the run ends
+const size_t OUTPUT_BUFFER_SIZE = 1 << 16;
+
+// struct for an integer printed right aligned in a field (the same as setw)
+struct Padded
+{
+    long long value;
+    int width;
+};
+
+// struct for a decimal printed with a fixed number of digits after the point (the same as fixed and setprecision)
+struct Fixed
+{
+    double value;
+    int precision;
+    int width = 0;
+};
+
+// struct for text printed left aligned in a field
+struct LeftAligned
+{
+    const char *text;
+    int width;
+};
+
+// class for output written through a large buffer, integers are formatted by hand and lines are never flushed on their own
+class OutputBuffer
+{
+    public:
+        // variables
+        std::ostream *target;
+        std::vector<char> buffer;
+        size_t used;
+
+    // constructor
+    OutputBuffer(std::ostream *t = &std::cout)
+    {
+        target = t;
+        buffer.resize(OUTPUT_BUFFER_SIZE);
+        used = 0;
+    }
+
+    // write out anything left in the buffer
+    ~OutputBuffer()
+    {
+        flush();
+    }
+
+    // copying would write the buffered output twice
+    OutputBuffer(const OutputBuffer &) = delete;
+    OutputBuffer &operator=(const OutputBuffer &) = delete;
+
+    // write the buffer to the target stream
+    void flush()
+    {
+        if (used > 0)
+        {
+            target->write(buffer.data(), used);
+            used = 0;
+        }
+        target->flush();
+    }
+
+    // send the output somewhere else, writing out what was buffered for the old target first
+    void set_target(std::ostream *t)
+    {
+        flush();
+        target = t;
+    }
+
+    // add characters to the buffer
+    void append(const char *text, size_t length)
+    {
+        if (used + length > buffer.size())
+        {
+            // make room, and write large blocks of text straight through
+            target->write(buffer.data(), used);
+            used = 0;
+            if (length > buffer.size())
+            {
+                target->write(text, length);
+                return;
+            }
+        }
+        std::copy(text, text + length, buffer.data() + used);
+        used += length;
+    }
+
+    // add an integer to the buffer, padded with spaces on the left to the width
+    void append_integer(long long value, int width = 0)
+    {
+        // write the digits backwards into a scratch buffer
+        char digits[24];
+        int length = 0;
+        unsigned long long magnitude = value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+        do
+        {
+            digits[sizeof(digits) - 1 - length] = '0' + magnitude % 10;
+            magnitude /= 10;
+            length++;
+        } while (magnitude > 0);
+        if (value < 0)
+        {
+            digits[sizeof(digits) - 1 - length] = '-';
+            length++;
+        }
+
+        // pad the field and add the digits
+        for (int i = length; i < width; ++i)
+        {
+            append(" ", 1);
+        }
+        append(digits + sizeof(digits) - length, length);
+    }
+
+    // operators to add each type of value
+    OutputBuffer &operator<<(const char *text)
+    {
+        append(text, std::char_traits<char>::length(text));
+        return *this;
+    }
+    OutputBuffer &operator<<(const std::string &text)
+    {
+        append(text.data(), text.size());
+        return *this;
+    }
+    OutputBuffer &operator<<(char c)
+    {
+        if (used == buffer.size())
+        {
+            append(&c, 1);
+        }
+        else
+        {
+            buffer[used++] = c;
+        }
+        return *this;
+    }
+    OutputBuffer &operator<<(int value)
+    {
+        append_integer(value);
+        return *this;
+    }
+    OutputBuffer &operator<<(long value)
+    {
+        append_integer(value);
+        return *this;
+    }
+    OutputBuffer &operator<<(long long value)
+    {
+        append_integer(value);
+        return *this;
+    }
+    OutputBuffer &operator<<(unsigned long value)
+    {
+        append_integer((long long)value);
+        return *this;
+    }
+    OutputBuffer &operator<<(Padded padded)
+    {
+        append_integer(padded.value, padded.width);
+        return *this;
+    }
+    OutputBuffer &operator<<(Fixed fixed_value)
+    {
+        char text[64];
+        int length = std::min((size_t)std::snprintf(text, sizeof(text), "%.*f", fixed_value.precision, fixed_value.value), sizeof(text) - 1);
+        for (int i = length; i < fixed_value.width; ++i)
+        {
+            append(" ", 1);
+        }
+        append(text, length);
+        return *this;
+    }
+    OutputBuffer &operator<<(LeftAligned left_aligned)
+    {
+        int length = std::char_traits<char>::length(left_aligned.text);
+        append(left_aligned.text, length);
+        for (int i = length; i < left_aligned.width; ++i)
+        {
+            append(" ", 1);
+        }
+        return *this;
+    }
+};
+
+#endif
@@ -0,0 +1,109 @@
+// header for the profiler that times the phases of the reference loop, used by the vm program and the virtual memory library
+#ifndef PROFILER_H
+#define PROFILER_H
+
+// include the necessary libraries
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "output.h"
+
+// phases of the reference loop that the profiler times
+enum ProfilePhase
+{
+    NO_PHASE = -1,
+    PHASE_PARSE,
+    PHASE_BACKGROUND,
+    PHASE_LOOKUP,
+    PHASE_VICTIM,
+    PHASE_FILL,
+    PHASE_PREFETCH,
+    PHASE_OUTPUT,
+    NUM_PROFILE_PHASES,
+};
+
+// names of the profile phases, in the same order as the enum
+const char *const PROFILE_PHASE_NAMES[NUM_PROFILE_PHASES] = {"parse", "background", "lookup", "victim", "fill", "prefetch", "output"};
+
+// hardware counters read by the profiler (cycles, instructions, cache misses, branch misses)
+const int NUM_PERF_COUNTERS = 4;
+
+// only one of this many trace lines is timed, so the cost of reading the clock and counters stays small
+const int PROFILE_SAMPLE_INTERVAL = 64;
+
+// class for the per-phase timing and hardware counters of the reference loop
+class Profiler
+{
+    public:
+        // variables
+        bool sampling;
+        long long lines;
+        int current_phase;
+        long long phase_start_ns;
+        uint64_t phase_start_counters[NUM_PERF_COUNTERS];
+        std::vector<long long> phase_samples;
+        std::vector<long long> phase_ns;
+        std::vector<std::vector<uint64_t>> phase_counters;
+        int counter_fds[NUM_PERF_COUNTERS];
+        bool counters_available;
+        std::string counters_error;
+        double overhead_ns;
+        double overhead_counters[NUM_PERF_COUNTERS];
+
+    // constructor
+    Profiler();
+
+    // close the hardware counters
+    ~Profiler();
+
+    // the counters are opened once, so a copy would close them twice
+    Profiler(const Profiler &) = delete;
+    Profiler &operator=(const Profiler &) = delete;
+
+    // open the hardware counters and measure the cost of reading them and the clock
+    void start();
+
+    // open the hardware counters as one group, so they are all read together (the profile still has the times if this fails)
+    void open_counters();
+
+    // read the clock and the hardware counters
+    long long read_now(uint64_t counters[]);
+
+    // a new trace line starts, decide if it is one of the sampled lines (output is always timed)
+    void start_line(bool always_sample = false)
+    {
+        sampling = always_sample || lines % PROFILE_SAMPLE_INTERVAL == 0;
+        lines++;
+    }
+
+    // end the current phase and start the next one (NO_PHASE just ends the current phase)
+    void enter(int phase)
+    {
+        if (!sampling || (phase == NO_PHASE && current_phase == NO_PHASE))
+        {
+            return;
+        }
+
+        // charge the time and counters since the last switch to the phase that just ended
+        uint64_t counters[NUM_PERF_COUNTERS] = {0, 0, 0, 0};
+        long long now = read_now(counters);
+        if (current_phase != NO_PHASE)
+        {
+            phase_samples[current_phase]++;
+            phase_ns[current_phase] += now - phase_start_ns;
+            for (int i = 0; i < NUM_PERF_COUNTERS; ++i)
+            {
+                phase_counters[current_phase][i] += counters[i] - phase_start_counters[i];
+            }
+        }
+        current_phase = phase;
+        phase_start_ns = now;
+        std::copy(counters, counters + NUM_PERF_COUNTERS, phase_start_counters);
+    }
+
+    // print the per-phase breakdown (the counter columns are left out if the counters are unavailable)
+    void print(OutputBuffer &output);
+};
+
+#endif
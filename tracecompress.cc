@@ -0,0 +1,163 @@
+// a preprocessing tool that collapses runs of references to the same page into one reference with a repeat count
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <sstream>
+#include <climits>
+#include "vm.h"
+
+// use the standard namespace
+using namespace std;
+
+// class for the run of references being collapsed
+class ReferenceRun
+{
+    public:
+        // variables
+        char operation;
+        int address;
+        int page_number;
+        int count;
+
+    // constructor
+    ReferenceRun()
+    {
+        operation = 0;
+        address = 0;
+        page_number = -1;
+        count = 0;
+    }
+
+    // check if a reference continues the run (the same page and operation, and the count does not overflow)
+    bool continues(char op, int page, int repeats)
+    {
+        return count > 0 && op == operation && page == page_number && count <= INT_MAX - repeats;
+    }
+
+    // write the run as one reference line, with the count only if it is repeated, returns false if there is no run
+    bool write(ostream &output)
+    {
+        if (count == 0)
+        {
+            return false;
+        }
+        output << operation << ' ' << hex << address << dec;
+        if (count > 1)
+        {
+            output << ' ' << count;
+        }
+        output << '\n';
+        count = 0;
+        return true;
+    }
+};
+
+int main(int argc, char *argv[])
+{
+    // check the number of arguments
+    if (argc != 3)
+    {
+        cerr << "Usage: " << argv[0] << " <input> <output> (- for standard input or output)" << endl;
+        return 1;
+    }
+    string input_filename = argv[1];
+    string output_filename = argv[2];
+
+    // open the input and output
+    ifstream input_file;
+    ofstream output_file;
+    if (input_filename != "-")
+    {
+        input_file.open(input_filename);
+        if (!input_file.is_open())
+        {
+            cerr << "File not found" << endl;
+            return 1;
+        }
+    }
+    if (output_filename != "-")
+    {
+        output_file.open(output_filename);
+        if (!output_file.is_open())
+        {
+            cerr << "Could not open output file" << endl;
+            return 1;
+        }
+    }
+    istream &input = input_filename == "-" ? cin : input_file;
+    ostream &output = output_filename == "-" ? cout : output_file;
+
+    // variables
+    string line;
+    int page_size = 0;
+    bool header_found = false;
+    bool debug = false;
+    long long references = 0;
+    long long lines_written = 0;
+    ReferenceRun run;
+
+    // collapse the references, every other line is copied as it is and ends the run before it
+    while (getline(input, line))
+    {
+        // references are collapsed once the header has the page size, except while debugging so each one is still
+        // printed
+        char operation;
+        int address;
+        int count;
+        if (header_found && !debug && page_size > 0 && line != "debug" && line != "nodebug" && line != "print" && !line.empty() && line[0] != '#'
+            && parse_reference(line, operation, address, count))
+        {
+            references += count;
+            if (run.continues(operation, address / page_size, count))
+            {
+                run.count += count;
+                continue;
+            }
+            lines_written += run.write(output);
+            run.operation = operation;
+            run.address = address;
+            run.page_number = address / page_size;
+            run.count = count;
+            continue;
+        }
+
+        // write the run before the line
+        lines_written += run.write(output);
+        output << line << '\n';
+        lines_written++;
+
+        // keep track of the header and debugging
+        if (line == "debug")
+        {
+            debug = true;
+        }
+        else if (line == "nodebug")
+        {
+            debug = false;
+        }
+        else if (!header_found && !line.empty() && line[0] != '#' && line != "print")
+        {
+            stringstream ss(line);
+            ss >> page_size;
+            header_found = true;
+        }
+        else if (header_found && !line.empty() && line[0] != '#' && line != "print" && parse_reference(line, operation, address, count))
+        {
+            references += count;
+        }
+    }
+
+    // write the last run
+    lines_written += run.write(output);
+    output.flush();
+    if (!output)
+    {
+        cerr << "Could not write output" << endl;
+        return 1;
+    }
+
+    // report how much smaller the trace is
+    cerr << "References: " << references << endl;
+    cerr << "Lines written: " << lines_written << endl;
+    return 0;
+}
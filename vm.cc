@@ -1,827 +1,904 @@
-// include the necessary libraries
+// the command line program for the virtual memory simulator, a thin client of the virtual memory library
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <sstream>
 #include <vector>
 #include <algorithm>
-#include <iomanip>
-#include <unordered_map>
+#include <cstdlib>
+#include <stdexcept>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include "vm.h"
+#include "output.h"
+#include "profiler.h"
+#include "checkpoint.h"
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 
 // use the standard namespace
 using namespace std;
 
-// enum for each of the algorithm types the virtual memory can use
-enum Algorithm
+// default number of references between checkpoints
+const long long DEFAULT_CHECKPOINT_INTERVAL = 1000000;
+
+// number of references parsed before they are run as one batch
+const size_t REFERENCE_BATCH_SIZE = 4096;
+
+// size of the buffer a streamed trace is read through, which is also the longest line it can have
+const size_t STREAM_BUFFER_SIZE = 1 << 16;
+
+// prefix of a trace name that makes the simulator listen on a Unix domain socket for the trace
+const string UNIX_SOCKET_PREFIX = "unix:";
+
+// struct for the optional settings given on the command line
+struct Options
 {
-    FIFO,
-    LRU,
-    OPT,
+    bool w_flag = false;
+    string cost_filename;
+    VirtualMemoryConfig config; // the settings of the simulation (the sizes and algorithm are filled in from the trace)
+    bool swap_stats = false;
+    int stats_every = 0;
+    int stats_interval_ms = 0;
+    bool stats_json = false;
+    string stats_filename;
+    string snapshot_filename;
+    bool profile = false;
+    string checkpoint_filename;
+    long long checkpoint_every = DEFAULT_CHECKPOINT_INTERVAL;
+    bool resume = false;
 };
 
-// enum for the state of each of the pages
-enum PageType
+// global variables
+OutputBuffer out;
+Profiler profiler;
+bool debug = false;
+VirtualMemory vm;
+Options options;
+vector<Reference> pending_references;
+bool stream_input = false;
+ofstream stats_file;
+ofstream snapshot_file;
+OutputBuffer snapshot_out(&snapshot_file);
+
+// read the flusher settings in the form "<high>,<low>[,<interval>]"
+bool parse_flusher(const string &value)
 {
-    UNUSED,
-    STOLEN,
-    MAPPED,
-};
+    // split the value on the commas
+    string values = value;
+    replace(values.begin(), values.end(), ',', ' ');
+    stringstream ss(values);
+
+    // get the watermarks and the optional interval
+    int high, low, interval = 1;
+    if (!(ss >> high >> low))
+    {
+        return false;
+    }
+    ss >> interval;
+    if (low < 0 || high < low || high > 100 || interval <= 0)
+    {
+        return false;
+    }
+
+    // save the flusher settings
+    options.config.flusher_enabled = true;
+    options.config.flusher_high_watermark = high;
+    options.config.flusher_low_watermark = low;
+    options.config.flusher_interval = interval;
+    return true;
+}
 
-// struct for the values of each of the pages
-struct Page
+// read the prefetch settings in the form "<policy>:<depth>"
+bool parse_prefetch(const string &value)
 {
-    int page_number;
-    PageType type;
-    int frame_number;
-    int on_disk;
-};
+    // split the value into the policy and the depth
+    size_t colon = value.find(':');
+    string policy = value.substr(0, colon);
+    int depth = colon == string::npos ? 4 : atoi(value.c_str() + colon + 1);
+    if (depth <= 0)
+    {
+        return false;
+    }
 
-// struct for the values of each of the frames
-struct Frame
+    // check the policy and set it
+    if (policy == "next")
+    {
+        options.config.prefetch_policy = PREFETCH_NEXT;
+    }
+    else if (policy == "stride")
+    {
+        options.config.prefetch_policy = PREFETCH_STRIDE;
+    }
+    else if (policy == "cluster")
+    {
+        options.config.prefetch_policy = PREFETCH_CLUSTER;
+    }
+    else
+    {
+        return false;
+    }
+    options.config.prefetch_depth = depth;
+    return true;
+}
+
+// parse the memory tiers ("<name>:<frames>:<latency>,..." listed fastest first), returns false if a tier is invalid
+bool parse_tiers(const string &value)
 {
-    int frame_number;
-    int page_number;
-    int in_use;
-    int dirty;
-    int first_use;
-    int last_use;
-};
+    stringstream ss(value);
+    string tier;
+    options.config.tiers.clear();
+    while (getline(ss, tier, ','))
+    {
+        // split the tier into its name, frames and latency
+        size_t first_colon = tier.find(':');
+        size_t second_colon = first_colon == string::npos ? string::npos : tier.find(':', first_colon + 1);
+        if (first_colon == 0 || second_colon == string::npos)
+        {
+            return false;
+        }
+        TierConfig tier_config;
+        tier_config.name = tier.substr(0, first_colon);
+        tier_config.num_frames = atoi(tier.c_str() + first_colon + 1);
+        tier_config.latency = atoll(tier.c_str() + second_colon + 1);
+        if (tier_config.num_frames <= 0 || tier_config.latency < 0)
+        {
+            return false;
+        }
+        options.config.tiers.push_back(tier_config);
+    }
+    return !options.config.tiers.empty();
+}
 
-// class for the virtual memory
-class VirtualMemory
+// apply the command line options to a newly created virtual memory
+void configure_virtual_memory()
 {
-    public:
-        // variables
-        int page_size;
-        int num_frames;
-        int num_pages;
-        int num_bs_blocks;
-        Algorithm algorithm;
-        vector<Frame> frames;
-        vector<Page> pages;
-        vector<int> backing_store;
-        int pages_referenced;
-        int pages_mapped;
-        int page_miss_instances;
-        int frame_stolen_instances;
-        int stolen_frames_written_to_swapspace;
-        int stolen_frames_recovered_from_swapspace;
+    if (options.profile)
+    {
+        vm.enable_profiling(profiler);
+    }
+    vm.set_debug(debug ? &out : nullptr);
+    if (options.stats_every > 0 || options.stats_interval_ms > 0)
+    {
+        vm.enable_stats_stream(stats_file.is_open() ? (ostream *)&stats_file : &cerr, options.stats_every, options.stats_interval_ms, options.stats_json);
+    }
+}
 
-    // constructor
-    VirtualMemory(int ps = 0, int nf = 0, int np = 0, int nbb = 0, Algorithm algo = Algorithm::FIFO)
-    {
-        page_size = ps;
-        num_frames = nf;
-        num_pages = np;
-        num_bs_blocks = nbb;
-        algorithm = algo;
-        pages_referenced = 0;
-        pages_mapped = 0;
-        page_miss_instances = 0;
-        frame_stolen_instances = 0;
-        stolen_frames_written_to_swapspace = 0;
-        stolen_frames_recovered_from_swapspace = 0;
-
-        // initialize the pages and frames
-        pages.resize(num_pages);
-        frames.resize(num_frames);
-        backing_store.resize(num_bs_blocks, -1); // initialize backing store with -1 indicating empty
-
-        // initialize the pages
-        for (int i = 0; i < num_pages; ++i)
+// page numbers of every reference in the trace, which OPT needs before it can start
+vector<int> future_page_numbers;
+
+// create the virtual memory with the settings from the command line and print its values
+void start_virtual_memory(int page_size, int num_frames, int num_pages, int num_bs_blocks, Algorithm algorithm, const string &algorithm_string)
+{
+    // create the virtual memory object with the sizes from the trace and the settings from the command line
+    options.config.page_size = page_size;
+    options.config.num_frames = num_frames;
+    options.config.num_pages = num_pages;
+    options.config.num_bs_blocks = num_bs_blocks;
+    options.config.algorithm = algorithm;
+    options.config.show_backing_store = options.w_flag;
+    options.config.future_page_numbers = move(future_page_numbers);
+    vm = VirtualMemory(options.config);
+    configure_virtual_memory();
+
+    // print the values
+    out << "Page size: " << page_size << '\n';
+    out << "Num frames: " << num_frames << '\n';
+    out << "Num pages: " << num_pages << '\n';
+    out << "Num backing blocks: " << num_bs_blocks << '\n';
+
+    // print the algorithm type
+    out << "Reclaim algorithm: " << algorithm_string << '\n';
+}
+
+// read the header line ("<page size> <frames> <pages> <backing blocks>") and create the virtual memory, returns false if a value is invalid
+bool create_virtual_memory(const string &line, Algorithm algorithm, const string &algorithm_string)
+{
+    // split the line to get the values
+    stringstream ss(line);
+    string token;
+    int page_size, num_frames, num_pages, num_bs_blocks;
+    if (!(ss >> token) || (page_size = stoi(token)) <= 0)
+    {
+        out << "Invalid page size" << '\n';
+        return false;
+    }
+    if (!(ss >> token) || (num_frames = stoi(token)) <= 0)
+    {
+        out << "Invalid number of frames" << '\n';
+        return false;
+    }
+    if (!(ss >> token) || (num_pages = stoi(token)) <= 0)
+    {
+        out << "Invalid number of pages" << '\n';
+        return false;
+    }
+    if (!(ss >> token) || (num_bs_blocks = stoi(token)) <= 0)
+    {
+        out << "Invalid number of backing store blocks" << '\n';
+        return false;
+    }
+
+    // the tiers have to split up exactly the frames in the header
+    if (!options.config.tiers.empty())
+    {
+        int tier_frames = 0;
+        for (const TierConfig &tier_config : options.config.tiers)
         {
-            pages[i].page_number = i;
-            pages[i].type = UNUSED;
-            pages[i].frame_number = -1;
-            pages[i].on_disk = 0; // assuming all pages are on disk for simplicity
+            tier_frames += tier_config.num_frames;
         }
-
-        // initialize the frames
-        for (int i = 0; i < num_frames; ++i)
+        if (tier_frames != num_frames)
         {
-            frames[i].frame_number = i;
-            frames[i].page_number = -1;
-            frames[i].first_use = -1;
-            frames[i].last_use = -1;
-            frames[i].dirty = 0;
-            frames[i].in_use = 0;
+            out << "Tier frames do not add up to the number of frames" << '\n';
+            return false;
         }
     }
 
-    // destructor
-    ~VirtualMemory()
+    start_virtual_memory(page_size, num_frames, num_pages, num_bs_blocks, algorithm, algorithm_string);
+    return true;
+}
+
+// parse a process line ("fork <pid>", "switch <pid>", or "exit <pid>") into the directive and the pid, returns false if
+// the line is not a process line (the pid is -1 if it is not valid)
+bool parse_process_line(const string &line, string &directive, int &pid)
+{
+    // check the first letter before the rest of the start of the line, since every reference line is looked at
+    char first = line.empty() ? 0 : line[0];
+    if ((first != 'f' || line.compare(0, 5, "fork ") != 0) && (first != 's' || line.compare(0, 7, "switch ") != 0)
+        && (first != 'e' || line.compare(0, 5, "exit ") != 0))
     {
-        frames.clear();
-        pages.clear();
-        backing_store.clear();
+        return false;
     }
 
-    // function to print the memory state
-    void print_memory_state()
+    // split the line into the directive and the pid
+    stringstream ss(line);
+    string extra;
+    ss >> directive;
+    if (!(ss >> pid) || pid < 0 || ss >> extra)
     {
-        // print the page table in the following format
-        /*
-        Page Table
-            0 type:STOLEN framenum:-1 ondisk:0
-            1 type:UNUSED
-            2 type:MAPPED framenum:3 ondisk:0
-        */
-        cout << "Page Table" << endl;
-        for (size_t i = 0; i < pages.size(); ++i)
+        pid = -1;
+    }
+    return true;
+}
+
+// find the page numbers of every reference in the trace, stopping at the first reference the run would stop on (the
+// pages of each process forked in the trace come after the pages of the processes before it, as in the virtual memory)
+void find_future_references(const vector<string> &lines)
+{
+    int page_size = 0;
+    int num_pages = 0;
+    bool header_found = false;
+    vector<int> process_pids = {0};
+    int current_process = 0;
+    for (const string &line : lines)
+    {
+        // skip the lines that are not references
+        if (line.empty() || line[0] == '#' || line == "debug" || line == "nodebug" || line == "print")
+        {
+            continue;
+        }
+
+        // the first line that is left is the header
+        if (!header_found)
+        {
+            int num_frames;
+            stringstream ss(line);
+            ss >> page_size >> num_frames >> num_pages;
+            header_found = true;
+            continue;
+        }
+
+        // follow the processes the same way the virtual memory does
+        string directive;
+        int pid;
+        if (parse_process_line(line, directive, pid))
         {
-            if (pages[i].type == PageType::UNUSED)
+            int process = pid == -1 ? -1 : find(process_pids.begin(), process_pids.end(), pid) - process_pids.begin();
+            if (process == -1 || (directive == "fork") != (process == (int)process_pids.size()) || (directive == "fork" && current_process == -1))
             {
-                cout << setw(5) << i << " type:UNUSED" << endl;
+                break;
             }
-            else
+            if (directive == "fork")
             {
-                cout << setw(5) << i << " ";
-                if (pages[i].type == PageType::STOLEN)
-                {
-                    cout << "type:STOLEN ";
-                }
-                else
-                {
-                    cout << "type:MAPPED ";
-                }
-                cout << "framenum:" << pages[i].frame_number << " ondisk:" << pages[i].on_disk << endl;
+                process_pids.push_back(pid);
             }
-        }
-
-        // print the frame table in the following format
-        /*
-        Frame Table
-            0 inuse:0
-            1 inuse:1 dirty:0 firstuse:1 lastuse:1
-            2 inuse:1 dirty:1 firstuse:2 lastuse:2
-        */
-        cout << "Frame Table" << endl;
-        for (size_t i = 0; i < frames.size(); ++i)
-        {
-            cout << setw(5) << i <<  " ";
-            if (frames[i].in_use == 0)
+            else if (directive == "switch")
             {
-                cout << "inuse:0" << endl;
+                current_process = process;
             }
             else
             {
-                cout << "inuse:" << frames[i].in_use << " dirty:" << frames[i].dirty << " first_use:" << frames[i].first_use << " last_use:" << frames[i].last_use << endl;
+                process_pids[process] = -1;
+                current_process = process == current_process ? -1 : current_process;
             }
+            continue;
         }
 
-        // print the statistics
-        cout << "Pages referenced: " << pages_referenced << endl;
-        cout << "Pages mapped: " << pages_mapped << endl;
-        cout << "Page miss instances: " << page_miss_instances << endl;
-        cout << "Frame stolen instances: " << frame_stolen_instances << endl;
-        cout << "Stolen frames written to swapspace: " << stolen_frames_written_to_swapspace << endl;
-        cout << "Stolen frames recovered from swapspace: " << stolen_frames_recovered_from_swapspace << endl;
-    }
-
-    // checks the number of pages mapped (needed to update the page table correctly)
-    void check_pages_mapped()
-    {
-        // reset the pages mapped
-        pages_mapped = 0;
-
-        // check if all pages are mapped
-        for (auto &page : pages)
+        // get the page number of the reference, once for each time it is repeated
+        char operation;
+        int address;
+        int count;
+        if (page_size <= 0 || current_process == -1 || !parse_reference(line, operation, address, count) || address / page_size >= num_pages)
         {
-            if (page.type != UNUSED)
-            {
-                pages_mapped++;
-            }
+            break;
         }
+        future_page_numbers.insert(future_page_numbers.end(), count, current_process * num_pages + address / page_size);
     }
+}
 
-    // run the FIFO algorithm for one instruction
-    void run_fifo_algorithm(const string &instruction, bool debug)
+// run the references waiting in the batch
+void flush_references()
+{
+    if (!pending_references.empty())
     {
-        // get the operation and address
-        char operation = instruction[0];
-        string address_hex = instruction.substr(1);
-        int address = stoi(address_hex, nullptr, 16);
-        int page_number = address / page_size;
+        vm.access_batch(pending_references);
+        pending_references.clear();
+    }
+}
 
-        // if debug is enabled, print the operation, address, and page number
-        if (debug)
-        {
-            cout << "Operation: " << operation << " Address: " << address_hex << " Page number: " << page_number << endl;
-        }
+// run every reference read so far, including the ones windowed OPT is holding back, before the state is used
+void finish_references()
+{
+    flush_references();
+    vm.finish_lookahead();
+}
 
-        // increment the pages referenced
-        pages_referenced++;
+// class for reading the lines of a trace that can only be read once (stdin, a FIFO, or a socket) through a fixed size
+// buffer, so the memory used does not grow with the trace
+class StreamReader
+{
+    public:
+        // variables
+        int fd;
+        vector<char> buffer;
+        size_t start;
+        size_t end;
+        bool at_end;
+
+    // constructor
+    StreamReader(int f)
+    {
+        fd = f;
+        buffer.resize(STREAM_BUFFER_SIZE);
+        start = 0;
+        end = 0;
+        at_end = false;
+    }
 
-        // check if the page is already in memory
-        for (auto &frame : frames)
+    // get the next line, returns false at the end of the stream
+    bool next_line(string &line)
+    {
+        while (true)
         {
-            // page is in memory
-            if (frame.page_number == page_number)
+            // return the next whole line in the buffer
+            char *newline = (char *)memchr(buffer.data() + start, '\n', end - start);
+            if (newline != nullptr)
             {
-                frame.last_use = pages_referenced;
-                // set the dirty bit if write operation
-                if (operation == 'w')
-                {
-                    frame.dirty = 1;
-                }
+                line.assign(buffer.data() + start, newline);
+                start = newline - buffer.data() + 1;
+                return true;
+            }
 
-                // if debug is enabled, print page hit
-                if (debug)
+            // the last line of the stream may not end with a newline
+            if (at_end)
+            {
+                if (start == end)
                 {
-                    cout << "Page hit" << endl;
+                    return false;
                 }
+                line.assign(buffer.data() + start, buffer.data() + end);
+                start = end;
+                return true;
+            }
 
-                // return since the page is already in memory
-                return;
+            // move the start of the line to the front of the buffer and read more of the stream after it
+            memmove(buffer.data(), buffer.data() + start, end - start);
+            end -= start;
+            start = 0;
+            if (end == buffer.size())
+            {
+                throw runtime_error("Line too long");
+            }
+            ssize_t count = read(fd, buffer.data() + end, buffer.size() - end);
+            if (count < 0 && errno != EINTR)
+            {
+                throw runtime_error("Could not read trace");
+            }
+            if (count == 0)
+            {
+                at_end = true;
+            }
+            else if (count > 0)
+            {
+                end += count;
             }
         }
+    }
+};
 
-        // if debug is enabled, that the page was missed (not in memory)
-        if (debug)
-        {
-            cout << "Page miss" << endl;
-        }
+// listen on a Unix domain socket and wait for one connection to send the trace, returns the connection or -1
+int accept_unix_socket(const string &path)
+{
+    // the path has to fit in the socket address
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path))
+    {
+        return -1;
+    }
+    memcpy(address.sun_path, path.c_str(), path.size());
 
-        // page miss
-        page_miss_instances++;
+    // a socket left behind by an earlier run is replaced, anything else at the path is not
+    struct stat info;
+    if (lstat(path.c_str(), &info) == 0 && S_ISSOCK(info.st_mode))
+    {
+        unlink(path.c_str());
+    }
 
-        // find an empty frame
-        for (auto &frame : frames)
-        {
-            // empty frame found
-            if (frame.in_use == 0)
-            {
-                // if debug is enabled, print that an empty frame found
-                if (debug)
-                {
-                    cout << "Empty frame found at frame " << frame.frame_number << endl;
-                }
+    // listen for the connection, then remove the path so nothing else can connect
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0)
+    {
+        return -1;
+    }
+    if (bind(listen_fd, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(listen_fd, 1) != 0)
+    {
+        close(listen_fd);
+        return -1;
+    }
+    int connection_fd;
+    do
+    {
+        connection_fd = accept(listen_fd, nullptr, nullptr);
+    } while (connection_fd < 0 && errno == EINTR);
+    close(listen_fd);
+    unlink(path.c_str());
+    return connection_fd;
+}
+
+// check if the trace is a stream instead of a regular file ("-" for stdin, "unix:<path>" for a socket, or a FIFO)
+bool is_stream_input(const string &filename)
+{
+    struct stat info;
+    return filename == "-" || filename.compare(0, UNIX_SOCKET_PREFIX.size(), UNIX_SOCKET_PREFIX) == 0
+        || (stat(filename.c_str(), &info) == 0 && !S_ISREG(info.st_mode) && !S_ISDIR(info.st_mode));
+}
 
-                // update the frame table
-                frame.page_number = page_number;
-                frame.first_use = pages_referenced;
-                frame.last_use = pages_referenced;
-                frame.in_use = 1;
+// open a streamed trace, waiting for the connection if it is a socket, returns the file descriptor or -1
+int open_stream_input(const string &filename)
+{
+    if (filename == "-")
+    {
+        return STDIN_FILENO;
+    }
+    if (filename.compare(0, UNIX_SOCKET_PREFIX.size(), UNIX_SOCKET_PREFIX) == 0)
+    {
+        return accept_unix_socket(filename.substr(UNIX_SOCKET_PREFIX.size()));
+    }
+    return open(filename.c_str(), O_RDONLY);
+}
 
-                // set the dirty bit if write operation
-                if (operation == 'w')
-                {
-                    frame.dirty = 1;
+// handle one line of the trace, returns false if the trace cannot continue
+bool process_line(const string &line, bool &first_non_comment, Algorithm algorithm, const string &algorithm_string)
+{
+    // time the line if the profiler is on (a print line is output, everything else starts with parsing)
+    if (options.profile)
+    {
+        profiler.start_line(line == "print");
+        profiler.enter(line == "print" ? PHASE_OUTPUT : PHASE_PARSE);
+    }
 
-                    if (debug)
-                    {
-                        cout << "Dirty bit set" << endl;
-                    }
-                }
+    if (debug)
+    {
+        out << "Line: " << line << '\n';
+    }
 
-                // update the page table
-                pages[page_number].frame_number = frame.frame_number;
-                pages[page_number].type = MAPPED;
-                pages[page_number].on_disk = 0;
-                return;
-            }
-        }
+    string directive;
+    int pid;
+    if (line.empty())
+    {
+        // the line is empty, so ignore it
+    }
+    else if (line == "debug")
+    {
+        // enable debugging
+        finish_references();
+        debug = true;
+        vm.set_debug(debug ? &out : nullptr);
+    }
+    else if (line == "nodebug")
+    {
+        // disable debugging
+        finish_references();
+        debug = false;
+        vm.set_debug(debug ? &out : nullptr);
+    }
+    else if (line == "print")
+    {
+        // print the output in the correct format, to the snapshot file if there is one
+        finish_references();
+        vm.print_memory_state(snapshot_file.is_open() ? snapshot_out : out);
 
-        // no empty frame found, apply fifo replacement
-        int oldest_frame_index = 0;
-        for (size_t i = 1; i < frames.size(); ++i)
+        // a streamed trace may run for a long time, so its output is written as soon as it is printed
+        if (stream_input)
         {
-            // find the oldest frame
-            if (frames[i].first_use < frames[oldest_frame_index].first_use)
-            {
-                oldest_frame_index = i;
-            }
+            (snapshot_file.is_open() ? snapshot_out : out).flush();
         }
-
-        // if debug is enabled, print that the oldest frame was found
+    }
+    else if (line[0] == '#')
+    {
+        // the line is a comment
         if (debug)
         {
-            cout << "Oldest frame found at frame " << frames[oldest_frame_index].frame_number << endl;
+            out << "Comment detected: " << line << '\n';
         }
-
-        // get the oldest frame
-        Frame &oldest_frame = frames[oldest_frame_index];
-        int oldest_page_number = oldest_frame.page_number;
-
-        // write the stolen frame to swapspace if dirty
-        if (oldest_frame.dirty)
+    }
+    else if (first_non_comment == false)
+    {
+        // the first non-comment line has the values for the virtual memory
+        if (!create_virtual_memory(line, algorithm, algorithm_string))
         {
-            backing_store[oldest_page_number] = oldest_frame.page_number;
-            stolen_frames_written_to_swapspace++;
-
-            // if debug is enabled, print that the oldest frame was stolen and written to swapspace
-            if (debug)
-            {
-                cout << "Frame " << oldest_frame.frame_number << " stolen and written to swapspace" << endl;
-            }
+            return false;
         }
-
-        // update the page table for the page being replaced
-        pages[oldest_page_number].type = STOLEN;
-        pages[oldest_page_number].frame_number = -1;
-
-        // if the value is dirty, write it to the backing store
-        if (oldest_frame.dirty)
+        first_non_comment = true;
+    }
+    else if (parse_process_line(line, directive, pid))
+    {
+        // fork, switch to, or exit a process once the references before it have run
+        finish_references();
+        if (pid == -1)
         {
-            pages[oldest_page_number].on_disk = 1;
+            throw runtime_error("Invalid process line: " + line);
         }
-        frame_stolen_instances++;
-
-        // if debug is enabled, print that the stolen frame was updated in the page table
-        if (debug)
+        if (directive == "fork")
         {
-            cout << "Stolen frame updated in page table" << endl;
+            vm.fork_process(pid);
         }
-
-        // if the page was previously written to the backing store
-        if (pages[page_number].on_disk == 1 && pages[page_number].frame_number == -1)
+        else if (directive == "switch")
         {
-            // recover the stolen frame from swapspace
-            stolen_frames_recovered_from_swapspace++;
-            backing_store[page_number] = -1; // clear the backing store entry
-
-            // if debug is enabled, print that the page was recovered from swapspace  
-            if (debug)
-            {
-                cout << "Page " << page_number << " recovered from swapspace" << endl;
-            }
+            vm.switch_process(pid);
         }
-
-        // update the frame table
-        oldest_frame.page_number = page_number;
-        oldest_frame.first_use = pages_referenced;
-        oldest_frame.last_use = pages_referenced;
-
-        // set dirty bit if the operation is write
-        if (operation == 'w')
+        else
         {
-            oldest_frame.dirty = 1;
+            vm.exit_process(pid);
         }
-        else
+    }
+    else
+    {
+        // run the algorithm on the reference (the references before a bad line run first, so the error is the same as
+        // without batching)
+        char operation;
+        int address;
+        int count;
+        string address_text;
+        if (debug ? !parse_reference(line, operation, address, count, address_text) : !parse_reference(line, operation, address, count))
         {
-            oldest_frame.dirty = 0;
+            finish_references();
+            throw runtime_error("Invalid reference: " + line);
         }
-        pages[page_number].frame_number = oldest_frame.frame_number;
-        pages[page_number].type = MAPPED;
 
-        // if debug is enabled, print that the oldest frame was updated in the frame table
+        // references are run in batches unless the debug output or profile has to follow each line, the debug output
+        // shows each reference with its address as written in the trace
         if (debug)
         {
-            cout << "Oldest frame updated in frame table" << endl;
+            for (int repeat = 0; repeat < count; ++repeat)
+            {
+                out << "Operation: " << operation << " Address: " << address_text << " Page number: " << address / options.config.page_size << '\n';
+                vm.access(operation, address);
+            }
         }
-    }
-
-    // run the LRU algorithm for one instruction
-    void run_lru_algorithm(const string &instruction, bool debug)
-    {
-        // get the operation and address
-        char operation = instruction[0];
-        string address_hex = instruction.substr(1);
-        int address = stoi(address_hex, nullptr, 16);
-        int page_number = address / page_size;
-
-        // if debug is enabled, print the operation, address, and page number
-        if (debug)
+        else if (options.profile)
         {
-            cout << "Operation: " << operation << " Address: " << address_hex << " Page number: " << page_number << endl;
+            vm.access(operation, address, count);
         }
-
-        // increment the pages referenced
-        pages_referenced++;
-
-        // check if the page is already in memory
-        for (auto &frame : frames)
+        else
         {
-            // page is in memory
-            if (frame.page_number == page_number)
+            pending_references.push_back(Reference{operation, address, count});
+            if (pending_references.size() >= REFERENCE_BATCH_SIZE)
             {
-                // update the last use
-                frame.last_use = pages_referenced;
-
-                // set the dirty bit if the operation is write
-                if (operation == 'w')
-                {
-                    frame.dirty = 1;
-                }
-
-                // if debug is enabled, print that the page was hit
-                if (debug)
-                {
-                    cout << "Page hit" << endl;
-                }
-
-                // return since the page is already in memory
-                return;
+                flush_references();
             }
         }
+    }
 
-        // if debug is enabled, print that the page was missed (not in memory)
-        if (debug)
-        {
-            cout << "Page miss" << endl;
-        }
+    // end the timing of the line (the engine has already ended it after a reference)
+    if (options.profile)
+    {
+        profiler.enter(NO_PHASE);
+    }
+    return true;
+}
 
-        // page miss
-        page_miss_instances++;
+// the command line without --resume, saved in each checkpoint so a run is only resumed with the same settings and trace
+string command_signature;
 
-        // find an empty frame
-        for (auto &frame : frames)
-        {
-            // empty frame found
-            if (frame.in_use == 0)
-            {
-                // if debug is enabled, print that an empty frame was found
-                if (debug)
-                {
-                    cout << "Empty frame found at frame " << frame.frame_number << endl;
-                }
+// number of references at which the next checkpoint is written
+long long next_checkpoint = 0;
 
-                // update the frame table
-                frame.page_number = page_number;
-                frame.first_use = pages_referenced;
-                frame.last_use = pages_referenced;
-                frame.in_use = 1;
+// write a checkpoint of the run, lines_done is the number of trace lines handled and byte_offset is where the next line starts
+void write_checkpoint(long long lines_done, long long byte_offset, bool first_non_comment)
+{
+    // where the run is in the trace
+    CheckpointWriter writer;
+    writer.data.append(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    writer.put_string(command_signature);
+    writer.put(lines_done);
+    writer.put(byte_offset);
+    writer.put(first_non_comment);
+    writer.put(debug);
+
+    // the sizes of the virtual memory and its state
+    writer.put(options.config.page_size);
+    writer.put(options.config.num_frames);
+    writer.put(options.config.num_pages);
+    writer.put(options.config.num_bs_blocks);
+    vm.save(writer);
+
+    if (!writer.write_file(options.checkpoint_filename))
+    {
+        throw runtime_error("Could not write checkpoint");
+    }
+}
 
-                // set the dirty bit if write operation
-                if (operation == 'w')
-                {
-                    frame.dirty = 1;
+// write a checkpoint if enough references have been run since the last one (file is the open trace, or nullptr if the
+// whole trace was read up front)
+void checkpoint_tick(long long lines_done, ifstream *file, bool first_non_comment)
+{
+    if (options.checkpoint_filename == "" || vm.stats().pages_referenced + (long long)pending_references.size() < next_checkpoint)
+    {
+        return;
+    }
 
-                    // if debug is enabled, print that the dirty bit was set
-                    if (debug)
-                    {
-                        cout << "Dirty bit set" << endl;
-                    }
-                }
+    // there is nothing left to resume at the end of the trace
+    long long byte_offset = file != nullptr ? (long long)file->tellg() : 0;
+    if (byte_offset < 0)
+    {
+        return;
+    }
+    flush_references();
+    write_checkpoint(lines_done, byte_offset, first_non_comment);
+    next_checkpoint = (vm.stats().pages_referenced / options.checkpoint_every + 1) * options.checkpoint_every;
+}
+
+// load the last checkpoint if there is one, returns 1 if the run was resumed, 0 if there is no checkpoint yet, and -1 if
+// the checkpoint cannot be used
+int resume_from_checkpoint(Algorithm algorithm, const string &algorithm_string, bool &first_non_comment, long long &lines_done, long long &byte_offset)
+{
+    // without a checkpoint the run starts from the beginning
+    if (access(options.checkpoint_filename.c_str(), F_OK) != 0)
+    {
+        return 0;
+    }
 
-                // update the page table
-                pages[page_number].frame_number = frame.frame_number;
-                pages[page_number].type = MAPPED;
-                pages[page_number].on_disk = 0;
-                return;
-            }
-        }
+    // the checkpoint has to come from the same command line
+    CheckpointReader reader;
+    string signature;
+    if (!reader.read_file(options.checkpoint_filename))
+    {
+        out << "Invalid checkpoint" << '\n';
+        return -1;
+    }
+    reader.get_string(signature);
+    if (reader.ok && signature != command_signature)
+    {
+        out << "Checkpoint was written by a different command" << '\n';
+        return -1;
+    }
 
-        // no empty frame found, apply lru replacement
-        int lru_frame_index = 0;
-        for (size_t i = 1; i < frames.size(); ++i)
-        {
-            // find the least recently used frame
-            if (frames[i].last_use < frames[lru_frame_index].last_use)
-            {
-                lru_frame_index = i;
+    // where the run is in the trace
+    reader.get(lines_done);
+    reader.get(byte_offset);
+    reader.get(first_non_comment);
+    reader.get(debug);
+
+    // create the virtual memory with the saved sizes, then load its state
+    int page_size = 0, num_frames = 0, num_pages = 0, num_bs_blocks = 0;
+    reader.get(page_size);
+    reader.get(num_frames);
+    reader.get(num_pages);
+    reader.get(num_bs_blocks);
+    if (!reader.ok || page_size <= 0 || num_frames <= 0 || num_pages <= 0 || num_bs_blocks <= 0)
+    {
+        out << "Invalid checkpoint" << '\n';
+        return -1;
+    }
+    start_virtual_memory(page_size, num_frames, num_pages, num_bs_blocks, algorithm, algorithm_string);
+    if (!vm.load(reader))
+    {
+        out << "Invalid checkpoint" << '\n';
+        return -1;
+    }
+    vm.set_debug(debug ? &out : nullptr);
+    next_checkpoint = (vm.stats().pages_referenced / options.checkpoint_every + 1) * options.checkpoint_every;
+    return 1;
+}
 
-                // if debug is enabled, print that the least recently used frame was found
-                if (debug)
-                {
-                    cout << "Least recently used frame found at frame " << frames[lru_frame_index].frame_number << endl;
-                }
-            }
-        }
+// main function
+int main(int argc, char *argv[])
+{
+    // create variables
+    string filename = "";
+    string algorithm_string = "";
 
-        // get the least recently used frame
-        Frame &lru_frame = frames[lru_frame_index];
-        int lru_page_number = lru_frame.page_number;
+    // check the number of arguments
+    if (argc < 3)
+    {
+        out << "Usage: " << argv[0] << " [-w] [--cost <costfile>] [--flusher <high>,<low>[,<interval>]] [--prefer-clean] [--swap-cluster <blocks>] [--swap-stats] [--prefetch <policy>[:<depth>]] [--stats-every <references>] [--stats-ms <milliseconds>] [--stats-format csv|json] [--stats-file <file>] [--snapshot-file <file>] [--profile] [--checkpoint <file>] [--checkpoint-every <references>] [--resume] [--opt-window <references>] [--tiers <name>:<frames>:<latency>,...] [--tier-placement fastest|free] [--promote-after <hits>] <algorithm> <filename>" << '\n';
+        return 1;
+    }
 
-        // if the frame is dirty, write it to swapspace
-        if (lru_frame.dirty)
+    // read the flags that come before the algorithm and filename
+    int arg_index = 1;
+    bool tier_flags = false;
+    while (arg_index < argc - 2)
+    {
+        string flag = argv[arg_index];
+        if (flag == "-w")
         {
-            backing_store[lru_page_number] = lru_frame.page_number;
-            stolen_frames_written_to_swapspace++;
-
-            // if debug is enabled, print that the frame was stolen and written to swapspace 
-            if (debug)
-            {
-                cout << "Frame " << lru_frame.frame_number << " stolen and written to swapspace" << endl;
-            }
+            options.w_flag = true;
+            arg_index++;
         }
-
-        // update the page table for the page being replaced
-        pages[lru_page_number].type = STOLEN;
-        pages[lru_page_number].frame_number = -1;
-        
-        // if the value is dirty, write it to the backing store
-        if (lru_frame.dirty)
+        else if (flag == "--cost" && arg_index + 1 < argc - 2)
         {
-            pages[lru_page_number].on_disk = 1;
+            options.cost_filename = argv[arg_index + 1];
+            arg_index += 2;
         }
-        frame_stolen_instances++;
-
-        // if debug is enabled, print that the stolen frame was updated in the page table
-        if (debug)
+        else if (flag == "--flusher" && arg_index + 1 < argc - 2)
         {
-            cout << "Stolen frame updated in page table" << endl;
+            if (!parse_flusher(argv[arg_index + 1]))
+            {
+                out << "Invalid flusher settings" << '\n';
+                return 1;
+            }
+            arg_index += 2;
         }
-
-        // if the page was previously written to the backing store
-        if (pages[page_number].on_disk == 1 && pages[page_number].frame_number == -1)
+        else if (flag == "--prefer-clean")
         {
-            // recover the stolen frame from swapspace
-            stolen_frames_recovered_from_swapspace++;
-            backing_store[page_number] = -1; // clear the backing store entry
-
-            // if debug is enabled, print that the page was recovered from swapspace
-            if (debug)
+            options.config.prefer_clean = true;
+            arg_index++;
+        }
+        else if (flag == "--swap-cluster" && arg_index + 1 < argc - 2)
+        {
+            options.config.swap_cluster_size = atoi(argv[arg_index + 1]);
+            if (options.config.swap_cluster_size <= 0)
             {
-                cout << "Page " << page_number << " recovered from swapspace" << endl;
+                out << "Invalid swap cluster size" << '\n';
+                return 1;
             }
+            arg_index += 2;
         }
-
-        // update the frame table
-        lru_frame.page_number = page_number;
-        lru_frame.first_use = pages_referenced;
-        lru_frame.last_use = pages_referenced;
-
-        // if the operation is write, set the dirty bit
-        if (operation == 'w')
+        else if (flag == "--swap-stats")
         {
-            lru_frame.dirty = 1;
+            options.swap_stats = true;
+            arg_index++;
         }
-        else
+        else if (flag == "--profile")
         {
-            lru_frame.dirty = 0;
+            options.profile = true;
+            arg_index++;
         }
-
-        // update the page table
-        pages[page_number].frame_number = lru_frame.frame_number;
-        pages[page_number].type = MAPPED;
-
-        // if debug is enabled, print that the least recently used frame was updated in the frame table
-        if (debug)
+        else if (flag == "--checkpoint" && arg_index + 1 < argc - 2)
         {
-            cout << "Least recently used frame updated in frame table" << endl;
+            options.checkpoint_filename = argv[arg_index + 1];
+            arg_index += 2;
         }
-    }
-
-    // run the OPT algorithm for all future instructions
-    void run_opt_algorithm(const vector<string> &instructions, bool debug)
-    {
-        // loop through all instructions
-        for (size_t i = 0; i < instructions.size(); ++i)
+        else if (flag == "--checkpoint-every" && arg_index + 1 < argc - 2)
         {
-            // get the operation and address
-            string instruction = instructions[i];
-            char operation = instruction[0];
-            string address_hex = instruction.substr(1);
-            int address = stoi(address_hex, nullptr, 16);
-            int page_number = address / page_size;
-
-            // if debug is enabled, print the operation, address, and page number
-            if (debug)
-            {
-                cout << "Operation: " << operation << " Address: " << address_hex << " Page number: " << page_number << endl;
-            }
-
-            // increment the pages referenced
-            pages_referenced++;
-
-            // check if the page is already in memory
-            bool page_hit = false;
-            for (auto &frame : frames)
+            options.checkpoint_every = atoll(argv[arg_index + 1]);
+            if (options.checkpoint_every <= 0)
             {
-                // page is in memory
-                if (frame.page_number == page_number)
-                {
-                    frame.last_use = pages_referenced;
-
-                    // if the operation is write, set the dirty bit
-                    if (operation == 'w')
-                    {
-                        frame.dirty = 1;
-                    }
-
-                    // if debug is enabled, print that the page was hit
-                    if (debug)
-                    {
-                        cout << "Page hit" << endl;
-                    }
-
-                    page_hit = true;
-                    break;
-                }
-            }
-
-            // if the page is in memory, continue to the next instruction
-            if (page_hit)
-            {
-                continue;
-            }
-
-            // if debug is enabled, print that the page was missed (not in memory)
-            if (debug)
-            {
-                cout << "Page miss" << endl;
-            }
-
-            // page miss
-            page_miss_instances++;
-
-            // find an empty frame
-            bool empty_frame_found = false;
-            for (auto &frame : frames)
-            {
-                // empty frame found
-                if (frame.in_use == 0)
-                {
-                    // if debug is enabled, print that an empty frame was found
-                    if (debug)
-                    {
-                        cout << "Empty frame found at frame " << frame.frame_number << endl;
-                    }
-
-                    // update the frame table
-                    frame.page_number = page_number;
-                    frame.first_use = pages_referenced;
-                    frame.last_use = pages_referenced;
-                    frame.in_use = 1;
-
-                    // set the dirty bit if write operation
-                    if (operation == 'w')
-                    {
-                        frame.dirty = 1;
-
-                        if (debug)
-                        {
-                            cout << "Dirty bit set" << endl;
-                        }
-                    }
-
-                    // update the page table
-                    pages[page_number].frame_number = frame.frame_number;
-                    pages[page_number].type = MAPPED;
-                    pages[page_number].on_disk = 0;
-                    empty_frame_found = true;
-                    break;
-                }
+                out << "Invalid checkpoint interval" << '\n';
+                return 1;
             }
-
-            // if an empty frame was found, continue to the next instruction
-            if (empty_frame_found)
-            {
-                continue;
-            }
-
-            // no empty frame found, apply OPT replacement
-            int opt_frame_index = -1;
-            int farthest_use = -1;
-            unordered_map<int, int> future_use_map;
-
-            // find the future use of each page
-            for (size_t j = i + 1; j < instructions.size(); ++j)
-            {
-                string future_instruction = instructions[j];
-                string future_address_hex = future_instruction.substr(1);
-                int future_address = stoi(future_address_hex, nullptr, 16);
-                int future_page_number = future_address / page_size;
-                // if the page is not in the future use map, add it
-                if (future_use_map.find(future_page_number) == future_use_map.end())
-                {
-                    future_use_map[future_page_number] = j;
-                }
-            }
-
-            // find the optimal frame
-            for (size_t k = 0; k < frames.size(); ++k)
-            {
-                int next_use = future_use_map.count(frames[k].page_number) ? future_use_map[frames[k].page_number] : -1;
-
-                // if the page is not used in the future, use it
-                if (next_use == -1)
-                {
-                    opt_frame_index = k;
-                    break;
-                }
-                else if (next_use > farthest_use)
-                {
-                    farthest_use = next_use;
-                    opt_frame_index = k;
-                }
-            }
-
-            // if debug is enabled, print that the optimal frame was found
-            if (debug)
+            arg_index += 2;
+        }
+        else if (flag == "--opt-window" && arg_index + 1 < argc - 2)
+        {
+            options.config.opt_window = atoi(argv[arg_index + 1]);
+            if (options.config.opt_window <= 0)
             {
-                cout << "Optimal frame found at frame " << frames[opt_frame_index].frame_number << endl;
+                out << "Invalid OPT window" << '\n';
+                return 1;
             }
-
-            // get the optimal frame
-            Frame &opt_frame = frames[opt_frame_index];
-            int opt_page_number = opt_frame.page_number;
-
-            // write the stolen frame to swapspace if dirty
-            if (opt_frame.dirty)
+            arg_index += 2;
+        }
+        else if (flag == "--tiers" && arg_index + 1 < argc - 2)
+        {
+            if (!parse_tiers(argv[arg_index + 1]))
             {
-                backing_store[opt_page_number] = opt_frame.page_number;
-                stolen_frames_written_to_swapspace++;
-
-                // if debug is enabled, print that the frame was stolen and written to swapspace
-                if (debug)
-                {
-                    cout << "Frame " << opt_frame.frame_number << " stolen and written to swapspace" << endl;
-                }
+                out << "Invalid tier settings" << '\n';
+                return 1;
             }
-
-            // update the page table for the page being replaced
-            pages[opt_page_number].type = STOLEN;
-            pages[opt_page_number].frame_number = -1;
-            
-            // if the value is dirty, write it to the backing store
-            if (opt_frame.dirty)
+            arg_index += 2;
+        }
+        else if (flag == "--tier-placement" && arg_index + 1 < argc - 2)
+        {
+            string placement = argv[arg_index + 1];
+            if (placement != "fastest" && placement != "free")
             {
-                pages[opt_page_number].on_disk = 1;
+                out << "Invalid tier placement" << '\n';
+                return 1;
             }
-            frame_stolen_instances++;
-
-            // if debug is enabled, print that the stolen frame was updated in the page table
-            if (debug)
+            options.config.tier_placement = placement == "fastest" ? PLACE_FASTEST : PLACE_FREE;
+            tier_flags = true;
+            arg_index += 2;
+        }
+        else if (flag == "--promote-after" && arg_index + 1 < argc - 2)
+        {
+            options.config.promote_after = atoi(argv[arg_index + 1]);
+            if (options.config.promote_after <= 0)
             {
-                cout << "Stolen frame updated in page table" << endl;
+                out << "Invalid promotion threshold" << '\n';
+                return 1;
             }
-
-            // recover the stolen frame from swapspace if it was previously written
-            if (pages[page_number].on_disk == 1 && pages[page_number].frame_number == -1)
+            tier_flags = true;
+            arg_index += 2;
+        }
+        else if (flag == "--resume")
+        {
+            options.resume = true;
+            arg_index++;
+        }
+        else if ((flag == "--stats-every" || flag == "--stats-ms") && arg_index + 1 < argc - 2)
+        {
+            int value = atoi(argv[arg_index + 1]);
+            if (value <= 0)
             {
-                stolen_frames_recovered_from_swapspace++;
-                backing_store[page_number] = -1; // clear the backing store entry
-
-                // if debug is enabled, print that the page was recovered from swapspace
-                if (debug)
-                {
-                    cout << "Page " << page_number << " recovered from swapspace" << endl;
-                }
+                out << "Invalid stats interval" << '\n';
+                return 1;
             }
-
-            // update the frame table
-            opt_frame.page_number = page_number;
-            opt_frame.first_use = pages_referenced;
-            opt_frame.last_use = pages_referenced;
-            
-            // set the dirty bit if the operation is write
-            if (operation == 'w')
+            if (flag == "--stats-every")
             {
-                opt_frame.dirty = 1;
+                options.stats_every = value;
             }
             else
             {
-                opt_frame.dirty = 0;
+                options.stats_interval_ms = value;
             }
-            pages[page_number].frame_number = opt_frame.frame_number;
-            pages[page_number].type = MAPPED;
-
-            // if debug is enabled, print that the optimal frame was updated in the frame table
-            if (debug)
+            arg_index += 2;
+        }
+        else if (flag == "--stats-format" && arg_index + 1 < argc - 2)
+        {
+            string format = argv[arg_index + 1];
+            if (format != "csv" && format != "json")
             {
-                cout << "Optimal frame updated in frame table" << endl;
+                out << "Invalid stats format" << '\n';
+                return 1;
             }
+            options.stats_json = format == "json";
+            arg_index += 2;
         }
-    }
-};
-
-// global variables
-bool debug = false;
-VirtualMemory vm = VirtualMemory(0, 0, 0, 0, FIFO);
-
-// function prototypes
-void run_opt_algorithm(const string &instruction, const vector<string> &future_instructions);
-void check_pages_mapped();
-
-// main function
-int main(int argc, char *argv[])
-{
-    // create variables
-    string filename = "";
-    string algorithm_string = "";
-
-    // check the number of arguments
-    if (argc < 2)
-    {
-        cout << "Usage: " << argv[0] << " <filename>" << endl;
-        return 1;
-    }
-    else if (argc > 4)
-    {
-        cout << "Too many arguments" << endl;
-        return 1;
-    }
-    else if (argc == 3)
-    {
-        algorithm_string = argv[1];
-        filename = argv[2];
-    }
-    else if (argc == 4)
-    {
-        if (string(argv[1]) == "-w")
+        else if (flag == "--stats-file" && arg_index + 1 < argc - 2)
+        {
+            options.stats_filename = argv[arg_index + 1];
+            arg_index += 2;
+        }
+        else if (flag == "--snapshot-file" && arg_index + 1 < argc - 2)
         {
-            // w_flag = true;
-            algorithm_string = argv[2];
-            filename = argv[3];
+            options.snapshot_filename = argv[arg_index + 1];
+            arg_index += 2;
+        }
+        else if (flag == "--prefetch" && arg_index + 1 < argc - 2)
+        {
+            if (!parse_prefetch(argv[arg_index + 1]))
+            {
+                out << "Invalid prefetch settings" << '\n';
+                return 1;
+            }
+            arg_index += 2;
         }
         else
         {
-            cout << "Invalid argument" << endl;
+            out << "Invalid argument" << '\n';
             return 1;
         }
     }
+    algorithm_string = argv[argc - 2];
+    filename = argv[argc - 1];
 
     // check algorithm and set it
     Algorithm algorithm;
@@ -839,214 +916,260 @@ int main(int argc, char *argv[])
     }
     else
     {
-        cout << "Invalid algorithm" << endl;
+        out << "Invalid algorithm" << '\n';
         return 1;
     }
 
-    // open file
-    ifstream file(filename);
-    if (!file.is_open())
+    // the prefetcher steals frames the way FIFO and LRU do, so it cannot be used with OPT
+    if (algorithm == OPT && options.config.prefetch_policy != NO_PREFETCH)
     {
-        cout << "File not found" << endl;
+        out << "Prefetching is not supported with OPTIMAL" << '\n';
         return 1;
     }
 
-    // variables
-    bool first_non_comment = false;
+    // placement and promotion only mean something between tiers
+    if (tier_flags && options.config.tiers.empty())
+    {
+        out << "Tier settings need --tiers" << '\n';
+        return 1;
+    }
 
-    // if debug is enabled, print the algorithm
-    if (debug)
+    // the window only changes how far OPT looks ahead
+    if (algorithm != OPT && options.config.opt_window > 0)
     {
-        cout << "Algorithm: " << algorithm_string << endl;
+        out << "The OPT window is only used with OPTIMAL" << '\n';
+        return 1;
     }
 
-    // check if the algorithm is OPT
-    if (algorithm == Algorithm::OPT)
+    // a stream can only be read once, so OPT has to use a window and there is no trace to resume in
+    stream_input = is_stream_input(filename);
+    if (stream_input && algorithm == OPT && options.config.opt_window == 0)
     {
+        out << "OPTIMAL needs --opt-window to read a stream" << '\n';
+        return 1;
+    }
+    if (stream_input && options.checkpoint_filename != "")
+    {
+        out << "Checkpoints need a trace file" << '\n';
+        return 1;
+    }
 
-        // get the first line
-        string line;
-        while (getline(file, line))
+    // resuming needs the checkpoint file to resume from
+    if (options.resume && options.checkpoint_filename == "")
+    {
+        out << "Resume needs a checkpoint file" << '\n';
+        return 1;
+    }
+
+    // remember the command line so a checkpoint is only resumed by the same command
+    for (int i = 1; i < argc; ++i)
+    {
+        if (string(argv[i]) != "--resume")
         {
-            if (!line.empty() && line[0] != '#')
-            {
-                break;
-            }
+            command_signature += string(argv[i]) + '\n';
         }
+    }
+    next_checkpoint = options.checkpoint_every;
+
+    // load the cost model if one was given
+    options.config.cost_enabled = options.cost_filename != "";
+    if (options.config.cost_enabled && !load_cost_model(options.cost_filename, options.config.cost))
+    {
+        out << "Invalid cost file" << '\n';
+        return 1;
+    }
 
-        // split the line to get the values
-        stringstream ss(line);
-        string token;
-        int page_size, num_frames, num_pages, num_bs_blocks;
-        // get the value of each of the variables
-        if (!(ss >> token) || (page_size = stoi(token)) <= 0)
+    // open the streaming statistics file if one was given
+    if (options.stats_filename != "")
+    {
+        stats_file.open(options.stats_filename);
+        if (!stats_file.is_open())
         {
-            cout << "Invalid page size" << endl;
+            out << "Could not open stats file" << '\n';
             return 1;
         }
-        if (!(ss >> token) || (num_frames = stoi(token)) <= 0)
+    }
+
+    // open the file for the memory snapshots if one was given
+    if (options.snapshot_filename != "")
+    {
+        snapshot_file.open(options.snapshot_filename);
+        if (!snapshot_file.is_open())
         {
-            cout << "Invalid number of frames" << endl;
+            out << "Could not open snapshot file" << '\n';
             return 1;
         }
-        if (!(ss >> token) || (num_pages = stoi(token)) <= 0)
+    }
+
+    // open the hardware counters and calibrate the profiler if profiling is on
+    if (options.profile)
+    {
+        profiler.start();
+    }
+
+    // open the stream, or the file if the trace is a regular file
+    int stream_fd = -1;
+    ifstream file;
+    if (stream_input)
+    {
+        stream_fd = open_stream_input(filename);
+        if (stream_fd < 0)
         {
-            cout << "Invalid number of pages" << endl;
+            out << "Could not open stream" << '\n';
             return 1;
         }
-        if (!(ss >> token) || (num_bs_blocks = stoi(token)) <= 0)
+    }
+    else
+    {
+        file.open(filename);
+        if (!file.is_open())
         {
-            cout << "Invalid number of backing store blocks" << endl;
+            out << "File not found" << '\n';
             return 1;
         }
+    }
 
-        // create the virtual memory object
-        vm = VirtualMemory(page_size, num_frames, num_pages, num_bs_blocks, algorithm);
-
-        // print the values
-        cout << "Page size: " << vm.page_size << endl;
-        cout << "Num frames: " << vm.num_frames << endl;
-        cout << "Num pages: " << vm.num_pages << endl;
-        cout << "Num backing blocks: " << vm.num_bs_blocks << endl;
+    // variables
+    bool first_non_comment = false;
+    long long lines_done = 0;
+    long long byte_offset = 0;
+    int resumed = 0;
 
-        // print the algorithm type
-        cout << "Reclaim algorithm: " << algorithm_string << endl;
+    // if debug is enabled, print the algorithm
+    if (debug)
+    {
+        out << "Algorithm: " << algorithm_string << '\n';
+    }
 
-        // read all instructions into a vector
-        vector<string> instructions;
-        while (getline(file, line))
+    // run the trace, stopping if the simulation runs into a fatal error
+    try
+    {
+        string line;
+        if (stream_input)
         {
-            if (!line.empty() && line[0] != '#')
+            // a stream is read through a fixed size buffer, one line at a time
+            StreamReader reader(stream_fd);
+            while (reader.next_line(line))
             {
-                instructions.push_back(line);
+                if (!process_line(line, first_non_comment, algorithm, algorithm_string))
+                {
+                    return 1;
+                }
             }
         }
-        
-        // run the OPT algorithm
-        vm.run_opt_algorithm(instructions, debug);
-
-        // check if all pages are mapped
-        vm.check_pages_mapped();
-    }
-    // if the algorithm is FIFO or LRU
-    else
-    {
-        // read file
-        string line;
-        while (getline(file, line))
+        else if (algorithm == Algorithm::OPT && options.config.opt_window == 0)
         {
-            if (debug)
+            // OPT needs to know every future reference, so read the whole trace first
+            vector<string> lines;
+            while (getline(file, line))
             {
-                cout << "Line: " << line << endl;
+                lines.push_back(line);
             }
+            find_future_references(lines);
 
-            if (line.empty())
+            // pick up from the last checkpoint if resuming
+            if (options.resume && (resumed = resume_from_checkpoint(algorithm, algorithm_string, first_non_comment, lines_done, byte_offset)) == -1)
             {
-                // the line is empty, so ignore it
+                return 1;
             }
-            else if (line == "debug")
+
+            // run each line of the trace
+            for (size_t i = lines_done; i < lines.size(); ++i)
             {
-                // enable debugging
-                debug = true;
+                if (!process_line(lines[i], first_non_comment, algorithm, algorithm_string))
+                {
+                    return 1;
+                }
+                checkpoint_tick(i + 1, nullptr, first_non_comment);
             }
-            else if (line == "nodebug")
+        }
+        else
+        {
+            // pick up from the last checkpoint if resuming, skipping the lines it already covers
+            if (options.resume && (resumed = resume_from_checkpoint(algorithm, algorithm_string, first_non_comment, lines_done, byte_offset)) == -1)
             {
-                // disable debugging
-                debug = false;
+                return 1;
             }
-            else if (line == "print")
+            if (resumed == 1)
             {
-                // print the output in the correct format
-                vm.print_memory_state();
+                file.seekg(byte_offset);
             }
-            else
+
+            // FIFO, LRU, and windowed OPT only need one line at a time
+            while (getline(file, line))
             {
-                // check if the line does not start with a #
-                if (line[0] != '#')
-                {
-                    // check if the first non-comment line has been read
-                    if (first_non_comment == false)
-                    {
-                        // split the line to get the values
-                        stringstream ss(line);
-                        string token;
-                        int page_size, num_frames, num_pages, num_bs_blocks;
-                        if (!(ss >> token) || (page_size = stoi(token)) <= 0)
-                        {
-                            cout << "Invalid page size" << endl;
-                            return 1;
-                        }
-                        if (!(ss >> token) || (num_frames = stoi(token)) <= 0)
-                        {
-                            cout << "Invalid number of frames" << endl;
-                            return 1;
-                        }
-                        if (!(ss >> token) || (num_pages = stoi(token)) <= 0)
-                        {
-                            cout << "Invalid number of pages" << endl;
-                            return 1;
-                        }
-                        if (!(ss >> token) || (num_bs_blocks = stoi(token)) <= 0)
-                        {
-                            cout << "Invalid number of backing store blocks" << endl;
-                            return 1;
-                        }
-
-                        // create the virtual memory object
-                        vm = VirtualMemory(page_size, num_frames, num_pages, num_bs_blocks, algorithm);
-
-                        // print the values
-                        cout << "Page size: " << vm.page_size << endl;
-                        cout << "Num frames: " << vm.num_frames << endl;
-                        cout << "Num pages: " << vm.num_pages << endl;
-                        cout << "Num backing blocks: " << vm.num_bs_blocks << endl;
-
-                        // print the algorithm type
-                        cout << "Reclaim algorithm: " << algorithm_string << endl;
-
-                        // set the first_non_comment to true
-                        first_non_comment = true;
-                    }
-                    // if the first non-comment line has been read
-                    else
-                    {
-                        // run the algorithm on that instruction
-                        if (vm.algorithm == Algorithm::FIFO)
-                        {
-                            // FIFO algorithm
-                            vm.run_fifo_algorithm(line, debug);
-
-                            // check if all pages are mapped
-                            vm.check_pages_mapped();
-                        }
-                        else if (vm.algorithm == Algorithm::LRU)
-                        {
-                            // LRU algorithm
-                            vm.run_lru_algorithm(line, debug);
-
-                            // check if all pages are mapped
-                            vm.check_pages_mapped();
-                        }
-                    }
-                }
-                // if the line starts with a #
-                else
+                if (!process_line(line, first_non_comment, algorithm, algorithm_string))
                 {
-                    // the line is a comment
-                    if (debug)
-                    {
-                        cout << "Comment detected: " << line << endl;
-                    }
+                    return 1;
                 }
+                lines_done++;
+                checkpoint_tick(lines_done, &file, first_non_comment);
             }
         }
+
+        // run the references left in the last batch and the ones windowed OPT is holding back
+        finish_references();
+    }
+    catch (const exception &error)
+    {
+        out << error.what() << '\n';
+        return 1;
     }
 
     // close file
     file.close();
+    if (stream_fd > STDIN_FILENO)
+    {
+        close(stream_fd);
+    }
     
-    // print the memory state
-    vm.print_memory_state();
+    // write the last line of the streaming statistics
+    vm.finish_stats_stream();
+
+    // print the memory state, timing it as output if the profiler is on
+    if (options.profile)
+    {
+        profiler.start_line(true);
+        profiler.enter(PHASE_OUTPUT);
+    }
+    vm.print_memory_state(out);
     
+    // print the backing store I/O locality if it was asked for
+    if (options.swap_stats)
+    {
+        vm.print_swap_stats(out);
+    }
+
+    // print how well the prefetcher did if it was on
+    if (options.config.prefetch_policy != NO_PREFETCH)
+    {
+        vm.print_prefetch_stats(out);
+    }
+
+    // print the sharing between processes if the trace forked any
+    if (vm.stats().processes_forked > 0)
+    {
+        vm.print_process_stats(out);
+    }
+
+    // print where the hits landed if the memory is split into tiers
+    if (!options.config.tiers.empty())
+    {
+        vm.print_tier_stats(out);
+    }
+
+    // print the estimated execution time if the cost model is on
+    if (options.config.cost_enabled)
+    {
+        vm.print_cost_summary(out);
+    }
+
+    // print the per-phase breakdown if the profiler is on
+    if (options.profile)
+    {
+        profiler.enter(NO_PHASE);
+        profiler.print(out);
+    }
+
     return 0;
 }
\ No newline at end of file
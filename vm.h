@@ -0,0 +1,258 @@
+// header for the virtual memory library (libvm), the simulator engine that the vm program is a thin client of
+#ifndef VM_H
+#define VM_H
+
+// include the necessary libraries
+#include <cstddef>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+// the buffered output, the profiler, and the checkpoint files have their own headers, and the engine is private to
+// the library, so they are only declared here
+class OutputBuffer;
+class Profiler;
+class CheckpointWriter;
+class CheckpointReader;
+class VirtualMemoryEngine;
+
+// enum for each of the algorithm types the virtual memory can use
+enum Algorithm
+{
+    FIFO,
+    LRU,
+    OPT,
+};
+
+// enum for the state of each of the pages
+enum PageType
+{
+    UNUSED,
+    STOLEN,
+    MAPPED,
+};
+
+// enum for the prefetch policies used when a page is missed
+enum PrefetchPolicy
+{
+    NO_PREFETCH,
+    PREFETCH_NEXT,
+    PREFETCH_STRIDE,
+    PREFETCH_CLUSTER,
+};
+
+// enum for where a page loaded on a miss goes when memory is split into tiers
+enum TierPlacement
+{
+    PLACE_FASTEST,
+    PLACE_FREE,
+};
+
+// struct for the latency of each memory event (in nanoseconds)
+struct CostModel
+{
+    long long hit;
+    long long minor_fault;
+    long long major_fault;
+    long long writeback;
+    long long tlb_miss;
+    int tlb_entries;
+    long long migration;
+    long long page_copy;
+};
+
+// default latencies used when a cost file does not set a value
+CostModel default_cost_model();
+
+// load the cost model from a file of "<event> <nanoseconds>" lines
+bool load_cost_model(const std::string &filename, CostModel &cost);
+
+// default number of blocks in a swap cluster
+const int DEFAULT_SWAP_CLUSTER_SIZE = 32;
+
+// struct for the settings of one tier of memory
+struct TierConfig
+{
+    std::string name;
+    int num_frames;
+    long long latency;
+};
+
+// struct for the settings a virtual memory is created with, everything after the algorithm is optional
+struct VirtualMemoryConfig
+{
+    int page_size = 0;
+    int num_frames = 0;
+    int num_pages = 0;
+    int num_bs_blocks = 0;
+    Algorithm algorithm = FIFO;
+    bool prefer_clean = false;
+    int swap_cluster_size = DEFAULT_SWAP_CLUSTER_SIZE;
+    PrefetchPolicy prefetch_policy = NO_PREFETCH;
+    int prefetch_depth = 0;
+    bool flusher_enabled = false;
+    int flusher_high_watermark = 0;
+    int flusher_low_watermark = 0;
+    int flusher_interval = 1;
+    bool cost_enabled = false;
+    CostModel cost = default_cost_model();
+    std::vector<TierConfig> tiers;        // the tiers of memory from fastest to slowest, their frames have to add up to num_frames
+    TierPlacement tier_placement = PLACE_FASTEST;
+    int promote_after = 0;                // hits in a slower tier before a page is promoted, 0 to never promote
+    std::vector<int> future_page_numbers; // the page number of every reference in the trace, only needed by OPT
+    int opt_window = 0;                   // number of references OPT looks ahead instead, 0 to use future_page_numbers
+    bool show_backing_store = false;      // print the backing store table and the block of each page with the memory state
+};
+
+// struct for one memory reference ('r' or 'w' and the address), repeated count times in a row
+struct Reference
+{
+    char operation;
+    int address;
+    int count = 1;
+};
+
+// struct for the counters of a virtual memory, returned by VirtualMemory::stats
+struct VirtualMemoryStats
+{
+    long long pages_referenced;
+    long long pages_mapped;
+    long long page_miss_instances;
+    long long frame_stolen_instances;
+    long long stolen_frames_written_to_swapspace;
+    long long stolen_frames_recovered_from_swapspace;
+    long long frames_cleaned_by_flusher;
+    long long pages_prefetched;
+    long long prefetched_pages_used;
+    long long prefetched_pages_evicted_unused;
+    long long tlb_misses;
+    long long estimated_time;
+    long long cow_faults;
+    long long swap_overflows;
+    long long processes_forked;
+};
+
+// struct for one row of the page table, returned by VirtualMemory::page_table
+struct PageTableEntry
+{
+    PageType type;
+    int frame_number;
+    int on_disk;
+};
+
+// struct for one row of the frame table, returned by VirtualMemory::frame_table
+struct FrameTableEntry
+{
+    int page_number; // the page in the frame (-1 if the frame is empty)
+    int in_use;
+    int dirty;
+    long long first_use;
+    long long last_use;
+};
+
+// class for the virtual memory, the tables and replacement policies are kept in the engine inside the library
+class VirtualMemory
+{
+    private:
+        // variables
+        std::unique_ptr<VirtualMemoryEngine> engine;
+
+    public:
+    // constructor with all of the settings of the simulation
+    VirtualMemory(const VirtualMemoryConfig &config = VirtualMemoryConfig());
+
+    // a virtual memory can be moved but not copied
+    VirtualMemory(VirtualMemory &&other);
+    VirtualMemory &operator=(VirtualMemory &&other);
+
+    // destructor
+    ~VirtualMemory();
+
+    // run one reference with the algorithm of the virtual memory (windowed OPT holds it back until finish_lookahead or
+    // until the window after it is full)
+    void access(char operation, int address);
+
+    // run a reference repeated count times in a row
+    void access(char operation, int address, int count);
+
+    // run a batch of references, the algorithm is only looked up once for the whole batch
+    void access_batch(const Reference *references, size_t count);
+
+    // run a batch of references held in a vector
+    void access_batch(const std::vector<Reference> &references);
+
+    // run the references held back for windowed OPT, at the end of the trace or before the state is looked at
+    void finish_lookahead();
+
+    // fork the running process, the child shares every page the parent has in memory or in swapspace until one of them
+    // writes to it
+    void fork_process(int child_pid);
+
+    // run the references that follow in another process
+    void switch_process(int pid);
+
+    // end a process, freeing the frames and blocks no other process shares
+    void exit_process(int pid);
+
+    // get the counters of the run so far
+    VirtualMemoryStats stats() const;
+
+    // get the page table (the pages of each forked process follow the pages of the processes before it)
+    std::vector<PageTableEntry> page_table() const;
+
+    // get the frame table
+    std::vector<FrameTableEntry> frame_table() const;
+
+    // print a line for each step of each reference to output, or stop if output is null
+    void set_debug(OutputBuffer *output);
+
+    // time the phases of each reference with the profiler
+    void enable_profiling(Profiler &profiler);
+
+    // turn on the streaming statistics, written every so many references and/or milliseconds
+    void enable_stats_stream(std::ostream *output, int every, int interval_ms, bool json);
+
+    // write the last line of the streaming statistics at the end of the trace
+    void finish_stats_stream();
+
+    // print the page table, frame table, (backing store table,) and counters
+    void print_memory_state(OutputBuffer &output);
+
+    // print the backing store I/O locality
+    void print_swap_stats(OutputBuffer &output);
+
+    // print how well the prefetcher did
+    void print_prefetch_stats(OutputBuffer &output);
+
+    // print the sharing between processes
+    void print_process_stats(OutputBuffer &output);
+
+    // print the hits, fills, promotions, and demotions of each tier
+    void print_tier_stats(OutputBuffer &output);
+
+    // print the estimated execution time and latency histogram of the cost model
+    void print_cost_summary(OutputBuffer &output);
+
+    // write the tables, counters, and policy state to a checkpoint (the settings are not saved, they are given again
+    // when the run is resumed)
+    void save(CheckpointWriter &writer);
+
+    // read the state written by save back into a virtual memory with the same settings, returns false if the
+    // checkpoint is cut short or does not fit
+    bool load(CheckpointReader &reader);
+};
+
+// parse a reference line ("r 1f" or "w 0x1f") into the operation and the address, returns false if there is no valid address
+bool parse_reference(const std::string &line, char &operation, int &address);
+
+// parse a reference line that may have a repeat count after the address ("r 1f 12"), the count is 1 if there is none,
+// returns false if there is no valid address or the count is not positive
+bool parse_reference(const std::string &line, char &operation, int &address, int &count);
+
+// parse a reference line with a repeat count, also giving the text of the address as it is in the line (everything
+// after the operation up to the end of the address), which the debug output echoes
+bool parse_reference(const std::string &line, char &operation, int &address, int &count, std::string &address_text);
+
+#endif
+
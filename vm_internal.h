@@ -0,0 +1,2351 @@
+// private header of the virtual memory library (libvm), with the tables, replacement policies, and engine behind the
+// VirtualMemory class of vm.h, only the library itself includes it
+#ifndef VM_INTERNAL_H
+#define VM_INTERNAL_H
+
+// include the necessary libraries
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+#include <chrono>
+#include <queue>
+#include <type_traits>
+#include "vm.h"
+#include "output.h"
+#include "profiler.h"
+#include "checkpoint.h"
+
+// use the standard namespace
+using namespace std;
+
+// struct for the values of each of the pages
+struct Page
+{
+    int page_number;
+    PageType type;
+    int frame_number;
+    int on_disk;
+    int bs_block;
+};
+
+// struct for the values of each of the frames
+struct Frame
+{
+    int frame_number;
+    int page_number; // the page in the frame (one of them if the frame is shared between processes)
+    int in_use;      // number of processes the page in the frame is mapped in (0 if the frame is empty)
+    int dirty;
+    long long first_use;
+    long long last_use;
+    int prefetched;
+};
+
+// struct for one tier of memory and its counters, the frames of each tier come after the frames of the tier before it
+struct Tier
+{
+    int first_frame;
+    int num_frames;
+    long long latency;    // latency of an access to a page in the tier (in nanoseconds)
+    long long hits;
+    long long fills;      // pages loaded into the tier by a miss or the prefetcher
+    long long promotions; // pages moved up into the tier
+    long long demotions;  // pages moved down into the tier
+};
+
+// struct for the values of each of the backing store blocks
+struct BackingStoreBlock
+{
+    int in_use;      // number of processes whose copy of the page is in the block (0 if the block is free)
+    int page_number; // the page in the block (one of them if the block is shared between processes)
+    long long reads;
+    long long writes;
+};
+
+// class for allocating backing store blocks, using a free bitmap split into clusters
+class SwapAllocator
+{
+    public:
+        // variables
+        int num_blocks;
+        int cluster_size;
+        int free_blocks;
+        vector<uint64_t> used_bitmap;
+        vector<int> cluster_free_blocks;
+        int current_cluster;
+        int cluster_next;
+
+    // constructor
+    SwapAllocator(int nb = 0, int cs = DEFAULT_SWAP_CLUSTER_SIZE)
+    {
+        num_blocks = nb;
+        cluster_size = cs;
+        free_blocks = nb;
+        current_cluster = -1;
+        cluster_next = 0;
+
+        // every block starts out free
+        used_bitmap.assign((num_blocks + 63) / 64, 0);
+        int num_clusters = (num_blocks + cluster_size - 1) / cluster_size;
+        cluster_free_blocks.resize(num_clusters);
+        for (int c = 0; c < num_clusters; ++c)
+        {
+            cluster_free_blocks[c] = cluster_length(c);
+        }
+    }
+
+    // write the allocator to a checkpoint
+    void save(CheckpointWriter &writer)
+    {
+        writer.put(num_blocks);
+        writer.put(cluster_size);
+        writer.put(free_blocks);
+        writer.put_vector(used_bitmap);
+        writer.put_vector(cluster_free_blocks);
+        writer.put(current_cluster);
+        writer.put(cluster_next);
+    }
+
+    // read the allocator back from a checkpoint
+    void load(CheckpointReader &reader)
+    {
+        reader.get(num_blocks);
+        reader.get(cluster_size);
+        reader.get(free_blocks);
+        reader.get_vector(used_bitmap);
+        reader.get_vector(cluster_free_blocks);
+        reader.get(current_cluster);
+        reader.get(cluster_next);
+    }
+
+    // number of blocks in a cluster (the last cluster may be short)
+    int cluster_length(int cluster)
+    {
+        return min(cluster_size, num_blocks - cluster * cluster_size);
+    }
+
+    // check if a block is in use
+    bool is_used(int block)
+    {
+        return (used_bitmap[block / 64] >> (block % 64)) & 1;
+    }
+
+    // mark a block as used and return it
+    int take(int block)
+    {
+        used_bitmap[block / 64] |= (uint64_t)1 << (block % 64);
+        cluster_free_blocks[block / cluster_size]--;
+        free_blocks--;
+        return block;
+    }
+
+    // allocate a block, returns -1 if the backing store is full
+    int allocate()
+    {
+        // keep filling the current cluster so writes stay contiguous
+        if (current_cluster != -1)
+        {
+            int cluster_end = current_cluster * cluster_size + cluster_length(current_cluster);
+            for (; cluster_next < cluster_end; ++cluster_next)
+            {
+                if (!is_used(cluster_next))
+                {
+                    return take(cluster_next++);
+                }
+            }
+        }
+
+        // start a new cluster that is completely free
+        for (size_t c = 0; c < cluster_free_blocks.size(); ++c)
+        {
+            if (cluster_free_blocks[c] == cluster_length(c))
+            {
+                current_cluster = c;
+                cluster_next = c * cluster_size;
+                return take(cluster_next++);
+            }
+        }
+
+        // no free cluster left, take the first free block anywhere
+        current_cluster = -1;
+        for (size_t word = 0; word < used_bitmap.size(); ++word)
+        {
+            if (~used_bitmap[word] != 0)
+            {
+                int block = word * 64 + __builtin_ctzll(~used_bitmap[word]);
+                if (block < num_blocks)
+                {
+                    return take(block);
+                }
+            }
+        }
+
+        // the backing store is full
+        return -1;
+    }
+
+    // release a block so it can be allocated again
+    void release(int block)
+    {
+        used_bitmap[block / 64] &= ~((uint64_t)1 << (block % 64));
+        cluster_free_blocks[block / cluster_size]++;
+        free_blocks++;
+    }
+};
+
+// largest number of TLB entries a cost file can ask for
+const int MAX_TLB_ENTRIES = 1 << 16;
+
+// number of references between looks at the clock for time based streaming statistics
+const int STATS_CLOCK_CHECK_INTERVAL = 4096;
+
+// number of power of two buckets in the latency histogram
+const int LATENCY_BUCKETS = 48;
+
+// tracing policy used when debug is off, every message compiles away to nothing
+struct NoTrace
+{
+    template <class... Args>
+    static void log(OutputBuffer *, const Args &...)
+    {
+    }
+};
+
+// tracing policy used when debug is on, every message is printed on its own line
+struct DebugTrace
+{
+    template <class... Args>
+    static void log(OutputBuffer *output, const Args &...args)
+    {
+        (*output << ... << args) << '\n';
+    }
+};
+
+// profiling policy used when --profile is off, the phase changes compile away to nothing
+struct NoProfile
+{
+    static void enter(Profiler *, int)
+    {
+    }
+};
+
+// profiling policy used when --profile is on, the phase changes go to the profiler
+struct PhaseProfile
+{
+    static void enter(Profiler *profiler, int phase)
+    {
+        profiler->enter(phase);
+    }
+};
+
+// class for a doubly linked list of frame numbers, kept in the order the frames should be stolen
+class FrameList
+{
+    public:
+        // variables
+        vector<int> prev;
+        vector<int> next;
+        vector<long long> key;
+        int head;
+        int tail;
+
+    // constructor
+    FrameList(int nf = 0)
+    {
+        prev.assign(nf, -1);
+        next.assign(nf, -1);
+        key.assign(nf, 0);
+        head = -1;
+        tail = -1;
+    }
+
+    // add a frame to the back of the list, frames with the same key (reference number) stay in frame number order
+    // so ties are broken the same way as a scan over the frame table
+    void push_back(int frame_number, long long frame_key)
+    {
+        // find the frame to insert after, then link the frame in
+        int after = tail;
+        while (after != -1 && key[after] == frame_key && after > frame_number)
+        {
+            after = prev[after];
+        }
+
+        key[frame_number] = frame_key;
+        insert_after(frame_number, after);
+    }
+
+    // link a frame in after another one (-1 for the front of the list)
+    void insert_after(int frame_number, int after)
+    {
+        prev[frame_number] = after;
+        next[frame_number] = after == -1 ? head : next[after];
+        if (after != -1)
+        {
+            next[after] = frame_number;
+        }
+        else
+        {
+            head = frame_number;
+        }
+        if (next[frame_number] != -1)
+        {
+            prev[next[frame_number]] = frame_number;
+        }
+        else
+        {
+            tail = frame_number;
+        }
+    }
+
+    // add a frame where its key puts it in a list kept in key order, walking from whichever end is closer to the key
+    void insert_in_order(int frame_number, long long frame_key)
+    {
+        key[frame_number] = frame_key;
+        if (head == -1 || frame_key - key[head] < key[tail] - frame_key)
+        {
+            int before = head;
+            while (before != -1 && key[before] <= frame_key)
+            {
+                before = next[before];
+            }
+            insert_after(frame_number, before == -1 ? tail : prev[before]);
+        }
+        else
+        {
+            int after = tail;
+            while (after != -1 && key[after] > frame_key)
+            {
+                after = prev[after];
+            }
+            insert_after(frame_number, after);
+        }
+    }
+
+    // put a frame that is not in the list in the place of one that is
+    void replace(int old_frame, int new_frame)
+    {
+        int after = prev[old_frame];
+        key[new_frame] = key[old_frame];
+        remove(old_frame);
+        insert_after(new_frame, after);
+    }
+
+    // swap the places of two frames that are both in the list
+    void exchange(int a, int b)
+    {
+        if (next[a] == b)
+        {
+            remove(b);
+            insert_after(b, prev[a]);
+        }
+        else if (next[b] == a)
+        {
+            remove(a);
+            insert_after(a, prev[b]);
+        }
+        else
+        {
+            int after_a = prev[a];
+            int after_b = prev[b];
+            remove(a);
+            remove(b);
+            insert_after(b, after_a);
+            insert_after(a, after_b);
+        }
+        swap(key[a], key[b]);
+    }
+
+    // write the list to a checkpoint
+    void save(CheckpointWriter &writer)
+    {
+        writer.put_vector(prev);
+        writer.put_vector(next);
+        writer.put_vector(key);
+        writer.put(head);
+        writer.put(tail);
+    }
+
+    // read the list back from a checkpoint
+    void load(CheckpointReader &reader)
+    {
+        reader.get_vector(prev);
+        reader.get_vector(next);
+        reader.get_vector(key);
+        reader.get(head);
+        reader.get(tail);
+    }
+
+    // take a frame out of the list
+    void remove(int frame_number)
+    {
+        if (prev[frame_number] != -1)
+        {
+            next[prev[frame_number]] = next[frame_number];
+        }
+        else
+        {
+            head = next[frame_number];
+        }
+        if (next[frame_number] != -1)
+        {
+            prev[next[frame_number]] = prev[frame_number];
+        }
+        else
+        {
+            tail = prev[frame_number];
+        }
+        prev[frame_number] = -1;
+        next[frame_number] = -1;
+    }
+
+    // walk the list from the front and return the first frame with the lowest rank (frames ranked -1 are skipped)
+    template <class Rank>
+    int first_with_lowest_rank(Rank rank)
+    {
+        int best_frame = -1;
+        int best_rank = INT_MAX;
+        for (int frame_number = head; frame_number != -1; frame_number = next[frame_number])
+        {
+            int frame_rank = rank(frame_number);
+            if (frame_rank >= 0 && frame_rank < best_rank)
+            {
+                best_frame = frame_number;
+                best_rank = frame_rank;
+
+                // nothing can beat a frame with rank 0
+                if (frame_rank == 0)
+                {
+                    break;
+                }
+            }
+        }
+        return best_frame;
+    }
+};
+
+// class for the simulated TLB, which maps each cached page to an entry and keeps the entries from the least to the most
+// recently used (empty entries are at the front), so a lookup does not scan every entry
+class Tlb
+{
+    public:
+        // variables
+        vector<int> entry_page;             // the page cached in each entry (-1 if the entry is empty)
+        unordered_map<int, int> page_entry; // the entry of each cached page
+        FrameList recency;
+
+    // set the number of entries, all of them empty
+    void resize(int num_entries)
+    {
+        entry_page.assign(num_entries, -1);
+        page_entry.clear();
+        page_entry.reserve(num_entries);
+        recency = FrameList(num_entries);
+        for (int entry = 0; entry < num_entries; ++entry)
+        {
+            recency.insert_after(entry, recency.tail);
+        }
+    }
+
+    // look up a page, returns true on a TLB hit, on a miss the page replaces the least recently used entry
+    bool lookup(int page_number)
+    {
+        // a hit only moves the entry to the back
+        auto cached = page_entry.find(page_number);
+        if (cached != page_entry.end())
+        {
+            if (cached->second != recency.tail)
+            {
+                recency.remove(cached->second);
+                recency.insert_after(cached->second, recency.tail);
+            }
+            return true;
+        }
+
+        // TLB miss, replace the least recently used entry
+        int entry = recency.head;
+        if (entry_page[entry] != -1)
+        {
+            page_entry.erase(entry_page[entry]);
+        }
+        entry_page[entry] = page_number;
+        page_entry[page_number] = entry;
+        recency.remove(entry);
+        recency.insert_after(entry, recency.tail);
+        return false;
+    }
+
+    // remove a page from the TLB, its entry is the next one used
+    void invalidate(int page_number)
+    {
+        auto cached = page_entry.find(page_number);
+        if (cached == page_entry.end())
+        {
+            return;
+        }
+        int entry = cached->second;
+        page_entry.erase(cached);
+        entry_page[entry] = -1;
+        recency.remove(entry);
+        recency.insert_after(entry, -1);
+    }
+
+    // write the TLB to a checkpoint
+    void save(CheckpointWriter &writer)
+    {
+        writer.put_vector(entry_page);
+        recency.save(writer);
+    }
+
+    // read the TLB back from a checkpoint, the map is built again from the entries
+    void load(CheckpointReader &reader)
+    {
+        reader.get_vector(entry_page);
+        recency.load(reader);
+        page_entry.clear();
+        for (size_t entry = 0; entry < entry_page.size(); ++entry)
+        {
+            if (entry_page[entry] != -1)
+            {
+                page_entry[entry_page[entry]] = entry;
+            }
+        }
+    }
+};
+
+// replacement policy for FIFO, which steals the frame that was filled the longest time ago
+class FifoPolicy
+{
+    public:
+        // variables
+        FrameList order;
+        static constexpr const char *victim_name = "Oldest";
+        static constexpr bool bulk_repeats = true; // repeated hits on one page can be run at once
+
+    // constructor
+    FifoPolicy(int nf = 0) : order(nf)
+    {
+    }
+
+    // a page was loaded into a frame
+    void loaded(int frame_number, long long reference)
+    {
+        order.push_back(frame_number, reference);
+    }
+
+    // a page that is already in a frame was referenced
+    void touched(int, long long)
+    {
+    }
+
+    // the page in a frame was stolen
+    void removed(int frame_number)
+    {
+        order.remove(frame_number);
+    }
+
+    // the page in a frame was moved to an empty frame
+    void moved(int from_frame, int to_frame)
+    {
+        order.replace(from_frame, to_frame);
+    }
+
+    // the pages in two frames were swapped
+    void exchanged(int a, int b)
+    {
+        order.exchange(a, b);
+    }
+
+    // pick the frame to steal
+    template <class Rank>
+    int select_victim(Rank rank)
+    {
+        return order.first_with_lowest_rank(rank);
+    }
+
+    // print the frame picked to steal
+    template <class Trace>
+    void log_victim(OutputBuffer *output, const vector<Frame> &, int frame_number)
+    {
+        Trace::log(output, victim_name, " frame found at frame ", frame_number);
+    }
+
+    // call visit on each frame in the order the frames would be stolen, until visit returns false
+    template <class Visit>
+    void for_each_in_steal_order(Visit visit)
+    {
+        for (int frame_number = order.head; frame_number != -1 && visit(frame_number); frame_number = order.next[frame_number])
+        {
+        }
+    }
+
+    // write the steal order to a checkpoint
+    void save(CheckpointWriter &writer)
+    {
+        order.save(writer);
+    }
+
+    // read the steal order back from a checkpoint
+    void load(CheckpointReader &reader)
+    {
+        order.load(reader);
+    }
+};
+
+// replacement policy for LRU, which steals the frame that was referenced the longest time ago
+class LruPolicy
+{
+    public:
+        // variables
+        FrameList order;
+        static constexpr const char *victim_name = "Least recently used";
+        static constexpr bool bulk_repeats = true; // repeated hits on one page can be run at once
+
+    // constructor
+    LruPolicy(int nf = 0) : order(nf)
+    {
+    }
+
+    // a page was loaded into a frame
+    void loaded(int frame_number, long long reference)
+    {
+        order.push_back(frame_number, reference);
+    }
+
+    // a page that is already in a frame was referenced, so it moves to the back
+    void touched(int frame_number, long long reference)
+    {
+        order.remove(frame_number);
+        order.push_back(frame_number, reference);
+    }
+
+    // the page in a frame was stolen
+    void removed(int frame_number)
+    {
+        order.remove(frame_number);
+    }
+
+    // the page in a frame was moved to an empty frame
+    void moved(int from_frame, int to_frame)
+    {
+        order.replace(from_frame, to_frame);
+    }
+
+    // the pages in two frames were swapped
+    void exchanged(int a, int b)
+    {
+        order.exchange(a, b);
+    }
+
+    // pick the frame to steal
+    template <class Rank>
+    int select_victim(Rank rank)
+    {
+        return order.first_with_lowest_rank(rank);
+    }
+
+    // print the frame picked to steal the way the original scan of the frame table did, each frame with an older last use
+    // than all the frames before it is printed as it is found, and the pick itself if the scan did not end on it
+    template <class Trace>
+    void log_victim(OutputBuffer *output, const vector<Frame> &frames, int frame_number)
+    {
+        if (is_same<Trace, NoTrace>::value)
+        {
+            return;
+        }
+        int oldest = -1;
+        for (size_t i = 0; i < frames.size(); ++i)
+        {
+            if (frames[i].in_use == 0)
+            {
+                continue;
+            }
+            if (oldest == -1)
+            {
+                oldest = i;
+            }
+            else if (frames[i].last_use < frames[oldest].last_use)
+            {
+                oldest = i;
+                Trace::log(output, victim_name, " frame found at frame ", oldest);
+            }
+        }
+        if (oldest != frame_number)
+        {
+            Trace::log(output, victim_name, " frame found at frame ", frame_number);
+        }
+    }
+
+    // call visit on each frame in the order the frames would be stolen, until visit returns false
+    template <class Visit>
+    void for_each_in_steal_order(Visit visit)
+    {
+        for (int frame_number = order.head; frame_number != -1 && visit(frame_number); frame_number = order.next[frame_number])
+        {
+        }
+    }
+
+    // write the steal order to a checkpoint
+    void save(CheckpointWriter &writer)
+    {
+        order.save(writer);
+    }
+
+    // read the steal order back from a checkpoint
+    void load(CheckpointReader &reader)
+    {
+        order.load(reader);
+    }
+};
+
+// class for a fixed size queue that reuses its slots, so it never allocates once it is created
+template <class T>
+class RingBuffer
+{
+    public:
+        // variables
+        vector<T> items;
+        size_t head;
+        size_t count;
+
+    // constructor
+    RingBuffer(size_t capacity = 0)
+    {
+        items.resize(capacity);
+        head = 0;
+        count = 0;
+    }
+
+    // add an item to the back (the ring has to have room for it)
+    void push_back(const T &item)
+    {
+        items[(head + count) % items.size()] = item;
+        count++;
+    }
+
+    // get the item at the front
+    T &front()
+    {
+        return items[head];
+    }
+
+    // remove the item at the front
+    void pop_front()
+    {
+        head = (head + 1) % items.size();
+        count--;
+    }
+
+    // get an item counting from the front
+    T &operator[](size_t index)
+    {
+        return items[(head + index) % items.size()];
+    }
+
+    // number of items in the ring
+    size_t size() const
+    {
+        return count;
+    }
+
+    // check if the ring has no items
+    bool empty() const
+    {
+        return count == 0;
+    }
+};
+
+// replacement policy for OPT, which steals the frame whose page is used again farthest in the future
+class OptPolicy
+{
+    public:
+        // variables
+        vector<long long> next_use;       // for each reference, the index of the next reference to its page (LLONG_MAX if none)
+        vector<long long> frame_next_use; // for each frame, the next use of the page in it (-1 if empty)
+        priority_queue<pair<long long, int>> farthest; // (next use, -frame number), stale entries are skipped when popped
+        int window;                       // number of references looked ahead, 0 if the whole trace is known
+        vector<int> window_page;          // with a window, a ring of the page of each reference in it
+        vector<int> frame_page;           // with a window, the page in each frame
+        vector<int> page_frame;           // with a window, the frame each page is in (-1 if none)
+        vector<long long> last_added;     // with a window, the index of the last reference to each page added to it (-1 if none)
+        static constexpr const char *victim_name = "Optimal";
+        static constexpr bool bulk_repeats = false; // every reference has its own next use, so repeats are run one by one
+
+    // constructor
+    OptPolicy(int nf = 0)
+    {
+        frame_next_use.assign(nf, -1);
+        window = 0;
+    }
+
+    // only look at the next references given to add_to_window instead of the whole trace, next_use becomes a ring with
+    // a slot for the reference being run and each reference in the window
+    void set_window(int w, int num_pages)
+    {
+        window = w;
+        next_use.assign(w + 1, LLONG_MAX);
+        window_page.assign(w + 1, -1);
+        frame_page.assign(frame_next_use.size(), -1);
+        page_frame.assign(num_pages, -1);
+        last_added.assign(num_pages, -1);
+    }
+
+    // make room in the window for the pages of a forked process
+    void add_pages(int total_pages)
+    {
+        page_frame.resize(total_pages, -1);
+        last_added.resize(total_pages, -1);
+    }
+
+    // add the next reference to the window (references_run is how many references have been run so far), filling in
+    // the next use of the last reference to the same page
+    void add_to_window(int page_number, long long references_run, long long index)
+    {
+        next_use[index % next_use.size()] = LLONG_MAX;
+        window_page[index % window_page.size()] = page_number;
+        if (page_number < 0 || page_number >= (int)last_added.size())
+        {
+            return;
+        }
+
+        // the last reference to the page is still waiting in the window, so this is its next use
+        long long last = last_added[page_number];
+        last_added[page_number] = index;
+        if (last >= references_run)
+        {
+            next_use[last % next_use.size()] = index;
+            return;
+        }
+
+        // otherwise the page has not been seen in the window since it was last run, so if it is in a frame this is the
+        // first use of that frame the window knows about
+        int frame_number = page_frame[page_number];
+        if (frame_number != -1 && frame_next_use[frame_number] == LLONG_MAX)
+        {
+            frame_next_use[frame_number] = index;
+            push_next_use(frame_number, index);
+        }
+    }
+
+    // work out the next use of every reference from the page numbers of the whole trace
+    void set_future_references(const vector<int> &page_numbers, int num_pages)
+    {
+        // the pages of forked processes come after the pages of the first process
+        next_use.assign(page_numbers.size(), LLONG_MAX);
+        int total_pages = num_pages;
+        for (int page_number : page_numbers)
+        {
+            total_pages = max(total_pages, page_number + 1);
+        }
+        vector<long long> following(total_pages, LLONG_MAX);
+        for (long long i = (long long)page_numbers.size() - 1; i >= 0; --i)
+        {
+            next_use[i] = following[page_numbers[i]];
+            following[page_numbers[i]] = i;
+        }
+    }
+
+    // remember the next use of the page in a frame for the given reference (numbered from 1)
+    void set_next_use(int frame_number, long long reference)
+    {
+        long long use;
+        if (window > 0)
+        {
+            use = next_use[(reference - 1) % next_use.size()];
+        }
+        else
+        {
+            use = reference - 1 < (long long)next_use.size() ? next_use[reference - 1] : LLONG_MAX;
+        }
+        frame_next_use[frame_number] = use;
+        push_next_use(frame_number, use);
+    }
+
+    // add the next use of a frame to the heap
+    void push_next_use(int frame_number, long long use)
+    {
+        farthest.push(make_pair(use, -frame_number));
+
+        // rebuild the heap when it is mostly stale entries
+        if (farthest.size() > 2 * frame_next_use.size() + 64)
+        {
+            rebuild_heap();
+        }
+    }
+
+    // build the heap again from the next use of each frame
+    void rebuild_heap()
+    {
+        farthest = priority_queue<pair<long long, int>>();
+        for (size_t f = 0; f < frame_next_use.size(); ++f)
+        {
+            if (frame_next_use[f] != -1)
+            {
+                farthest.push(make_pair(frame_next_use[f], -(int)f));
+            }
+        }
+    }
+
+    // write the next use of each frame to a checkpoint (the next use of each reference comes from the trace again, or
+    // from the references held back for the window)
+    void save(CheckpointWriter &writer)
+    {
+        writer.put_vector(frame_next_use);
+        writer.put_vector(frame_page);
+        writer.put_vector(page_frame);
+    }
+
+    // read the next use of each frame back from a checkpoint
+    void load(CheckpointReader &reader)
+    {
+        reader.get_vector(frame_next_use);
+        reader.get_vector(frame_page);
+        reader.get_vector(page_frame);
+        rebuild_heap();
+
+        // the window is filled again by adding the held back references, which only have to know where each page is
+        if (window > 0)
+        {
+            last_added.assign(page_frame.size(), -1);
+        }
+    }
+
+    // a page was loaded into a frame
+    void loaded(int frame_number, long long reference)
+    {
+        if (window > 0)
+        {
+            int page_number = window_page[(reference - 1) % window_page.size()];
+            frame_page[frame_number] = page_number;
+            page_frame[page_number] = frame_number;
+        }
+        set_next_use(frame_number, reference);
+    }
+
+    // a page that is already in a frame was referenced
+    void touched(int frame_number, long long reference)
+    {
+        set_next_use(frame_number, reference);
+    }
+
+    // the page in a frame was stolen
+    void removed(int frame_number)
+    {
+        frame_next_use[frame_number] = -1;
+        if (window > 0)
+        {
+            release_page(frame_page[frame_number], frame_number, -1);
+            frame_page[frame_number] = -1;
+        }
+    }
+
+    // point a page that is still in a frame at a new frame (a page that left the frame for a copy of its own is left
+    // where it is)
+    void release_page(int page_number, int frame_number, int new_frame)
+    {
+        if (page_number >= 0 && page_frame[page_number] == frame_number)
+        {
+            page_frame[page_number] = new_frame;
+        }
+    }
+
+    // the page in a frame was moved to an empty frame
+    void moved(int from_frame, int to_frame)
+    {
+        frame_next_use[to_frame] = frame_next_use[from_frame];
+        frame_next_use[from_frame] = -1;
+        push_next_use(to_frame, frame_next_use[to_frame]);
+        if (window > 0)
+        {
+            frame_page[to_frame] = frame_page[from_frame];
+            frame_page[from_frame] = -1;
+            release_page(frame_page[to_frame], from_frame, to_frame);
+        }
+    }
+
+    // the pages in two frames were swapped
+    void exchanged(int a, int b)
+    {
+        swap(frame_next_use[a], frame_next_use[b]);
+        push_next_use(a, frame_next_use[a]);
+        push_next_use(b, frame_next_use[b]);
+        if (window > 0)
+        {
+            int page_a = frame_page[a];
+            int page_b = frame_page[b];
+            bool a_mapped = page_a >= 0 && page_frame[page_a] == a;
+            bool b_mapped = page_b >= 0 && page_frame[page_b] == b;
+            swap(frame_page[a], frame_page[b]);
+            if (a_mapped)
+            {
+                page_frame[page_a] = b;
+            }
+            if (b_mapped)
+            {
+                page_frame[page_b] = a;
+            }
+        }
+    }
+
+    // pick the frame to steal (frames that are never used again count as farthest, lowest frame number first)
+    template <class Rank>
+    int select_victim(Rank rank)
+    {
+        // throw away the stale entries at the top of the heap
+        while (!farthest.empty() && frame_next_use[-farthest.top().second] != farthest.top().first)
+        {
+            farthest.pop();
+        }
+
+        // the top of the heap is the victim unless something else has to be taken into account
+        if (!farthest.empty() && rank(-farthest.top().second) == 0)
+        {
+            return -farthest.top().second;
+        }
+
+        // otherwise look at every frame for the lowest rank, then the farthest next use
+        int best_frame = -1;
+        int best_rank = INT_MAX;
+        for (int f = 0; f < (int)frame_next_use.size(); ++f)
+        {
+            int frame_rank = frame_next_use[f] == -1 ? -1 : rank(f);
+            if (frame_rank < 0)
+            {
+                continue;
+            }
+            if (frame_rank < best_rank || (frame_rank == best_rank && frame_next_use[f] > frame_next_use[best_frame]))
+            {
+                best_frame = f;
+                best_rank = frame_rank;
+            }
+        }
+        return best_frame;
+    }
+
+    // print the frame picked to steal
+    template <class Trace>
+    void log_victim(OutputBuffer *output, const vector<Frame> &, int frame_number)
+    {
+        Trace::log(output, victim_name, " frame found at frame ", frame_number);
+    }
+
+    // call visit on each frame in the order the frames would be stolen (the farthest next use first, lowest frame number
+    // first on ties), until visit returns false
+    template <class Visit>
+    void for_each_in_steal_order(Visit visit)
+    {
+        vector<int> order;
+        for (int f = 0; f < (int)frame_next_use.size(); ++f)
+        {
+            if (frame_next_use[f] != -1)
+            {
+                order.push_back(f);
+            }
+        }
+        sort(order.begin(), order.end(), [this](int a, int b)
+        {
+            return frame_next_use[a] != frame_next_use[b] ? frame_next_use[a] > frame_next_use[b] : a < b;
+        });
+        for (int frame_number : order)
+        {
+            if (!visit(frame_number))
+            {
+                break;
+            }
+        }
+    }
+};
+
+// class for the engine behind VirtualMemory, which holds the tables and runs the references with the replacement policy
+class VirtualMemoryEngine
+{
+    public:
+        // variables
+        int page_size;
+        int num_frames;
+        int num_pages;
+        int num_bs_blocks;
+        Algorithm algorithm;
+        vector<Frame> frames;
+        vector<Page> pages;
+        vector<BackingStoreBlock> backing_store;
+        SwapAllocator swap_allocator;
+        bool show_backing_store;
+        long long pages_referenced;
+        long long pages_mapped;
+        long long page_miss_instances;
+        long long frame_stolen_instances;
+        long long stolen_frames_written_to_swapspace;
+        long long stolen_frames_recovered_from_swapspace;
+
+        // replacement policy variables
+        FifoPolicy fifo_policy;
+        LruPolicy lru_policy;
+        OptPolicy opt_policy;
+        int next_empty_frame;
+        void (VirtualMemoryEngine::*reference_handler)(char, int);
+        void (VirtualMemoryEngine::*batch_handler)(const Reference *, size_t);
+        void (VirtualMemoryEngine::*lookahead_handler)();
+        int opt_window;
+        RingBuffer<Reference> lookahead; // references OPT has been given but not run yet, when it has a window
+        OutputBuffer *debug_output; // where the debug messages are printed (null if debug is off)
+        Profiler *profiler;         // the profiler that times the phases of each reference (null if profiling is off)
+
+        // swap I/O variables
+        int last_bs_block;
+        long long swap_seek_distance;
+        long long swap_sequential_ios;
+        long long swap_overflows; // pages written to swapspace when every backing store block was in use
+
+        // prefetch variables
+        PrefetchPolicy prefetch_policy;
+        int prefetch_depth;
+        int last_stream_page;
+        int last_stream_stride;
+        long long pages_prefetched;
+        long long prefetched_pages_used;
+        long long prefetched_pages_evicted_unused;
+        vector<int> prefetch_candidates; // the pages a miss wants to bring in, kept between misses so they do not allocate
+
+        // streaming statistics variables
+        ostream *stats_out;
+        int stats_every;
+        int stats_interval_ms;
+        bool stats_json;
+        long long stats_last_references;
+        long long stats_last_misses;
+        chrono::steady_clock::time_point stats_start;
+        chrono::steady_clock::time_point stats_last_time;
+
+        // cost model variables
+        bool cost_enabled;
+        CostModel cost;
+        Tlb tlb;
+        long long tlb_misses;
+        long long estimated_time;
+        vector<long long> latency_histogram;
+
+        // writeback variables
+        bool flusher_enabled;
+        int flusher_high_watermark;
+        int flusher_low_watermark;
+        int flusher_interval;
+        long long frames_cleaned_by_flusher;
+        int num_dirty_frames; // frames with the dirty bit set, so the flusher does not have to count them
+        bool prefer_clean;
+
+        // memory tier variables
+        bool tiers_enabled;
+        vector<Tier> tiers;
+        vector<string> tier_names;
+        vector<int> frame_tier;            // the tier of each frame
+        vector<long long> frame_tier_hits; // hits on the page in each frame since it came into its tier
+        vector<FrameList> tier_recency;    // the frames of each tier from the least to the most recently used
+        TierPlacement tier_placement;
+        int promote_after;
+
+        // process variables
+        vector<int> process_pids;   // the pid of each process (-1 once it exits), the pages of process i start at page i * num_pages
+        int current_process;        // the process running the references (-1 if it exited)
+        int page_base;              // the first page of the running process
+        int processes_forked;
+        int processes_exited;
+        long long cow_faults;
+        int frames_saved;           // mappings of a page to a frame that another process also has the page mapped to
+        int peak_frames_saved;
+
+    // constructor
+    VirtualMemoryEngine(int ps = 0, int nf = 0, int np = 0, int nbb = 0, Algorithm algo = Algorithm::FIFO);
+
+    // constructor with all of the settings of the simulation
+    VirtualMemoryEngine(const VirtualMemoryConfig &config);
+
+    // write the tables, counters, and policy state to a checkpoint (the settings from the command line are not saved,
+    // they are given again when the run is resumed)
+    void save(CheckpointWriter &writer);
+
+    // read the state written by save back into a virtual memory with the same sizes and settings, returns false if the
+    // checkpoint is cut short or does not fit
+    bool load(CheckpointReader &reader);
+
+    // function to print the memory state to the output
+    void print_memory_state(OutputBuffer &output);
+
+    // marks a page as mapped, counting it in the pages mapped the first time it is used (pages mapped is the number of
+    // pages that are not UNUSED in the page tables of the running processes)
+    void mark_page_mapped(int page_number)
+    {
+        if (pages[page_number].type == UNUSED)
+        {
+            pages_mapped++;
+        }
+        pages[page_number].type = MAPPED;
+    }
+
+    // turn on the streaming statistics, written every so many references and/or milliseconds
+    void enable_stats_stream(ostream *out, int every, int interval_ms, bool json);
+
+    // write one line of the streaming statistics (only the counters, never the tables)
+    void write_stats_line();
+
+    // write a line of the streaming statistics if one is due (called before each reference)
+    void stats_tick()
+    {
+        // nothing to do if the streaming statistics are off or no references have been made since the last line
+        if (stats_out == nullptr || pages_referenced == stats_last_references)
+        {
+            return;
+        }
+
+        // write a line every so many references
+        if (stats_every > 0 && pages_referenced % stats_every == 0)
+        {
+            write_stats_line();
+        }
+        // only look at the clock every so often so the time interval stays cheap
+        else if (stats_interval_ms > 0 && pages_referenced % STATS_CLOCK_CHECK_INTERVAL == 0)
+        {
+            auto now = chrono::steady_clock::now();
+            if (chrono::duration_cast<chrono::milliseconds>(now - stats_last_time).count() >= stats_interval_ms)
+            {
+                write_stats_line();
+            }
+        }
+    }
+
+    // write the last line of the streaming statistics at the end of the trace
+    void finish_stats_stream();
+
+    // set the number of blocks in each swap cluster
+    void set_swap_cluster_size(int cluster_size);
+
+    // keep track of how far the backing store has to seek for an I/O
+    void record_swap_io(int block)
+    {
+        if (last_bs_block != -1)
+        {
+            swap_seek_distance += abs(block - last_bs_block);
+            if (block == last_bs_block + 1)
+            {
+                swap_sequential_ios++;
+            }
+        }
+        last_bs_block = block;
+    }
+
+    // write a page to its backing store block, allocating a block the first time (when every block is in use, the block
+    // of a page whose copy is out of date is taken, and if there is none the write overflows: the page is still marked
+    // as on disk so the counters are the same as with enough blocks, but it has no block to be read back from)
+    void write_to_swapspace(int page_number)
+    {
+        // give the page a block if it does not have one yet
+        if (pages[page_number].bs_block == -1)
+        {
+            int block = swap_allocator.allocate();
+            if (block == -1 && reclaim_stale_block())
+            {
+                block = swap_allocator.allocate();
+            }
+            if (block == -1)
+            {
+                swap_overflows++;
+                pages[page_number].on_disk = 1;
+                return;
+            }
+            pages[page_number].bs_block = block;
+            backing_store[block].in_use = 1;
+            backing_store[block].page_number = page_number;
+        }
+
+        // write the page to the block
+        int block = pages[page_number].bs_block;
+        backing_store[block].writes++;
+        pages[page_number].on_disk = 1;
+        record_swap_io(block);
+    }
+
+    // read a page back from its backing store block (there is nothing to read if its write overflowed)
+    void read_from_swapspace(int page_number)
+    {
+        int block = pages[page_number].bs_block;
+        if (block == -1)
+        {
+            return;
+        }
+        backing_store[block].reads++;
+        record_swap_io(block);
+    }
+
+    // free the backing store block of a page in a dirty frame, whose copy in the block is out of date and is written
+    // again anyway when the frame is stolen, returns false if no block can be freed this way
+    bool reclaim_stale_block()
+    {
+        for (int frame_number = 0; frame_number < num_frames; ++frame_number)
+        {
+            const Frame &frame = frames[frame_number];
+            if (frame.in_use == 0 || !frame.dirty)
+            {
+                continue;
+            }
+
+            // the block can only be freed if every process with the page in it shares the frame
+            int block = pages[frame.page_number].bs_block;
+            if (block != -1 && backing_store[block].in_use <= frame.in_use)
+            {
+                for_each_sharer(frame_number, [this](int sharer)
+                {
+                    if (pages[sharer].bs_block != -1)
+                    {
+                        release_block(sharer);
+                    }
+                });
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // write the page in a frame to swapspace, every process sharing the frame shares the block it is written to
+    void write_frame_to_swapspace(int frame_number)
+    {
+        // a block that still has an older copy of the page for a process that does not share the frame is left to it
+        Frame &frame = frames[frame_number];
+        int block = pages[frame.page_number].bs_block;
+        if (block != -1 && backing_store[block].in_use > frame.in_use)
+        {
+            for_each_sharer(frame_number, [this](int sharer) { drop_block(sharer); });
+        }
+
+        // write the page, then give the block to the other processes sharing the frame
+        write_to_swapspace(frame.page_number);
+        block = pages[frame.page_number].bs_block;
+        if (block == -1)
+        {
+            for_each_sharer(frame_number, [this](int sharer) { pages[sharer].on_disk = 1; });
+            return;
+        }
+        for_each_sharer(frame_number, [this, block](int sharer)
+        {
+            if (pages[sharer].bs_block != block)
+            {
+                pages[sharer].bs_block = block;
+                backing_store[block].in_use++;
+            }
+            pages[sharer].on_disk = 1;
+        });
+    }
+
+    // let go of the backing store block of a page and forget that it was on disk
+    void drop_block(int page_number)
+    {
+        if (pages[page_number].bs_block != -1)
+        {
+            release_block(page_number);
+        }
+        pages[page_number].on_disk = 0;
+    }
+
+    // let go of the backing store block of a page, freeing the block once no process has its copy of the page there
+    void release_block(int page_number)
+    {
+        int block = pages[page_number].bs_block;
+        pages[page_number].bs_block = -1;
+
+        // free the block, or keep it with one of the other processes that have the page in it
+        BackingStoreBlock &bs_block = backing_store[block];
+        bs_block.in_use--;
+        if (bs_block.in_use == 0)
+        {
+            bs_block.page_number = -1;
+            swap_allocator.release(block);
+        }
+        else if (bs_block.page_number == page_number)
+        {
+            for (int holder = page_number % num_pages; holder < (int)pages.size(); holder += num_pages)
+            {
+                if (pages[holder].bs_block == block)
+                {
+                    bs_block.page_number = holder;
+                    break;
+                }
+            }
+        }
+    }
+
+    // call visit on each page mapped to a frame, a shared frame holds the same page of every process sharing it
+    template <class Visit>
+    void for_each_sharer(int frame_number, Visit visit)
+    {
+        const Frame &frame = frames[frame_number];
+        if (frame.in_use <= 1)
+        {
+            visit(frame.page_number);
+            return;
+        }
+        for (int sharer = frame.page_number % num_pages; sharer < (int)pages.size(); sharer += num_pages)
+        {
+            if (pages[sharer].type == MAPPED && pages[sharer].frame_number == frame_number)
+            {
+                visit(sharer);
+            }
+        }
+    }
+
+    // point the pages mapped to one frame at another, and the pages mapped to the other at the first (the page tables of
+    // every process are looked at, so a page moved between tiers stays shared)
+    void remap_frame(int page_number, int from_frame, int to_frame)
+    {
+        for (int sharer = page_number % num_pages; sharer < (int)pages.size(); sharer += num_pages)
+        {
+            if (pages[sharer].type != MAPPED)
+            {
+                continue;
+            }
+            if (pages[sharer].frame_number == from_frame)
+            {
+                pages[sharer].frame_number = to_frame;
+            }
+            else if (pages[sharer].frame_number == to_frame)
+            {
+                pages[sharer].frame_number = from_frame;
+            }
+        }
+    }
+
+    // check if a dirty frame can be written to swapspace without overflowing (it needs a backing store block of its own)
+    bool can_write_back(const Frame &frame)
+    {
+        int block = pages[frame.page_number].bs_block;
+        return frame.dirty == 0 || (block != -1 && backing_store[block].in_use <= frame.in_use) || swap_allocator.free_blocks > 0;
+    }
+
+    // function to print the backing store I/O locality
+    void print_swap_stats(OutputBuffer &output);
+
+    // turn on a prefetch policy that brings in up to depth pages on each miss
+    void enable_prefetch(PrefetchPolicy policy, int depth);
+
+    // bring a page into memory ahead of its use, returns false if there is no frame to put it in
+    template <class Policy, class Trace>
+    bool prefetch_page(Policy &policy, int page_number)
+    {
+        // use an empty frame if there is one, otherwise steal a frame that was not filled by the current reference
+        int frame_number = take_empty_frame();
+        if (frame_number == -1)
+        {
+            frame_number = policy.select_victim(victim_rank(true));
+            if (frame_number == -1)
+            {
+                return false;
+            }
+
+            // the write of a dirty frame is off the critical path
+            steal_frame<Policy, Trace>(policy, frame_number);
+        }
+
+        // read the page from swapspace if it was written there
+        if (pages[page_number].on_disk == 1 && pages[page_number].bs_block != -1)
+        {
+            read_from_swapspace(page_number);
+        }
+
+        // update the frame table
+        fill_frame(frame_number, page_number, 'r');
+        frames[frame_number].prefetched = 1;
+        policy.loaded(frame_number, pages_referenced);
+        if (tiers_enabled)
+        {
+            tier_loaded(frame_number);
+        }
+        pages_prefetched++;
+
+        Trace::log(debug_output, "Page ", page_number, " prefetched into frame ", frame_number);
+        return true;
+    }
+
+    // run the prefetch policy after a miss (or the first hit on a prefetched page)
+    template <class Policy, class Trace>
+    void prefetch(Policy &policy, int page_number, bool recovered)
+    {
+        // nothing to do if prefetching is off
+        if (prefetch_policy == NO_PREFETCH)
+        {
+            return;
+        }
+
+        // find the pages the policy wants to bring in
+        vector<int> &candidates = prefetch_candidates;
+        candidates.clear();
+        if (prefetch_policy == PREFETCH_NEXT)
+        {
+            // the next pages after the one that was referenced
+            for (int i = 1; i <= prefetch_depth; ++i)
+            {
+                candidates.push_back(page_number + i);
+            }
+        }
+        else if (prefetch_policy == PREFETCH_STRIDE)
+        {
+            // only prefetch once the same stride has been seen twice in a row
+            int stride = last_stream_page == -1 ? 0 : page_number - last_stream_page;
+            if (stride != 0 && stride == last_stream_stride)
+            {
+                for (int i = 1; i <= prefetch_depth; ++i)
+                {
+                    candidates.push_back(page_number + i * stride);
+                }
+            }
+            last_stream_page = page_number;
+            last_stream_stride = stride;
+        }
+        else if (prefetch_policy == PREFETCH_CLUSTER && recovered && pages[page_number].bs_block != -1)
+        {
+            // the other pages in the same aligned window of backing store blocks (a page whose write overflowed has none)
+            int block = pages[page_number].bs_block;
+            int window_start = block - block % prefetch_depth;
+            for (int b = window_start; b < window_start + prefetch_depth && b < num_bs_blocks; ++b)
+            {
+                if (b != block && backing_store[b].in_use)
+                {
+                    candidates.push_back(backing_store[b].page_number);
+                }
+            }
+        }
+
+        // bring in the pages of the same process that are not already in memory
+        int first_page = page_number - page_number % num_pages;
+        for (int candidate : candidates)
+        {
+            if (candidate < first_page || candidate >= first_page + num_pages || pages[candidate].type == MAPPED)
+            {
+                continue;
+            }
+            if (!prefetch_page<Policy, Trace>(policy, candidate))
+            {
+                break;
+            }
+        }
+    }
+
+    // count the first use of a prefetched page and let the prefetcher keep up with the stream
+    template <class Policy, class Trace>
+    void prefetch_hit(Policy &policy, Frame &frame)
+    {
+        if (frame.prefetched)
+        {
+            frame.prefetched = 0;
+            prefetched_pages_used++;
+            prefetch<Policy, Trace>(policy, frame.page_number, false);
+        }
+    }
+
+    // function to print how well the prefetcher did
+    void print_prefetch_stats(OutputBuffer &output);
+
+    // split the frames into tiers of memory, fastest first, with the placement and promotion policies between them
+    void enable_tiers(const vector<TierConfig> &tier_configs, TierPlacement placement, int promote_hits);
+
+    // function to print the hits and page moves of each tier
+    void print_tier_stats(OutputBuffer &output);
+
+    // keep track of a page that was just loaded into a frame in its tier
+    void tier_loaded(int frame_number)
+    {
+        int tier = frame_tier[frame_number];
+        tiers[tier].fills++;
+        tier_recency[tier].push_back(frame_number, frames[frame_number].last_use);
+        frame_tier_hits[frame_number] = 0;
+    }
+
+    // count a hit on the page in a frame in its tier and make it the most recently used page of the tier
+    void tier_touched(int frame_number)
+    {
+        int tier = frame_tier[frame_number];
+        tiers[tier].hits++;
+        frame_tier_hits[frame_number]++;
+        tier_recency[tier].remove(frame_number);
+        tier_recency[tier].push_back(frame_number, frames[frame_number].last_use);
+    }
+
+    // charge the copy of a page from one tier to another to the cost model
+    void charge_migration()
+    {
+        if (cost_enabled)
+        {
+            estimated_time += cost.migration;
+        }
+    }
+
+    // move the page in a frame to an empty frame (or one whose page was just stolen) in another tier
+    template <class Policy>
+    void move_page(Policy &policy, int from_frame, int to_frame)
+    {
+        // copy the frame, then point the page at its new frame
+        Frame &source = frames[from_frame];
+        Frame &target = frames[to_frame];
+        target.page_number = source.page_number;
+        target.in_use = source.in_use;
+        set_dirty(target, source.dirty);
+        target.first_use = source.first_use;
+        target.last_use = source.last_use;
+        target.prefetched = source.prefetched;
+        remap_frame(target.page_number, from_frame, to_frame);
+
+        // the replacement policy and the tiers follow the page
+        policy.moved(from_frame, to_frame);
+        tier_recency[frame_tier[from_frame]].remove(from_frame);
+        tier_recency[frame_tier[to_frame]].insert_in_order(to_frame, target.last_use);
+        frame_tier_hits[to_frame] = 0;
+        charge_migration();
+    }
+
+    // swap the pages in two frames in different tiers
+    template <class Policy>
+    void swap_pages(Policy &policy, int a, int b)
+    {
+        // swap the frames, then point each page at its new frame
+        swap(frames[a], frames[b]);
+        swap(frames[a].frame_number, frames[b].frame_number);
+        remap_frame(frames[a].page_number, a, b);
+        if (frames[a].page_number % num_pages != frames[b].page_number % num_pages)
+        {
+            remap_frame(frames[b].page_number, a, b);
+        }
+
+        // the replacement policy and the tiers follow the pages
+        policy.exchanged(a, b);
+        tier_recency[frame_tier[a]].remove(a);
+        tier_recency[frame_tier[b]].remove(b);
+        tier_recency[frame_tier[a]].insert_in_order(a, frames[a].last_use);
+        tier_recency[frame_tier[b]].insert_in_order(b, frames[b].last_use);
+        frame_tier_hits[a] = 0;
+        frame_tier_hits[b] = 0;
+        charge_migration();
+        charge_migration();
+    }
+
+    // make room in the fastest tier for a page that is going into a free frame in a slower tier, by moving the least
+    // recently used page of each tier above the free frame one tier down, returns the free frame in the fastest tier
+    template <class Policy, class Trace>
+    int demote_for_fill(Policy &policy, int frame_number)
+    {
+        for (int tier = frame_tier[frame_number] - 1; tier >= 0; --tier)
+        {
+            int coldest = tier_recency[tier].head;
+            if (coldest == -1)
+            {
+                break;
+            }
+            move_page(policy, coldest, frame_number);
+            tiers[tier + 1].demotions++;
+            Trace::log(debug_output, "Page ", frames[frame_number].page_number, " demoted from frame ", coldest, " to frame ", frame_number);
+            frame_number = coldest;
+        }
+        return frame_number;
+    }
+
+    // move a page up a tier once it has been hit often enough in a slower tier, swapping it with the least recently used
+    // page of the tier above
+    template <class Policy, class Trace>
+    void promote_page(Policy &policy, int page_number)
+    {
+        // the prefetcher may have stolen the page since it was hit
+        if (promote_after == 0 || pages[page_number].type != MAPPED)
+        {
+            return;
+        }
+        int frame_number = pages[page_number].frame_number;
+        int tier = frame_tier[frame_number];
+        if (tier == 0 || frame_tier_hits[frame_number] < promote_after || tier_recency[tier - 1].head == -1)
+        {
+            return;
+        }
+
+        int coldest = tier_recency[tier - 1].head;
+        swap_pages(policy, frame_number, coldest);
+        tiers[tier - 1].promotions++;
+        tiers[tier].demotions++;
+        Trace::log(debug_output, "Page ", page_number, " promoted from frame ", frame_number, " to frame ", coldest);
+    }
+
+    // the running process forks a child with the given pid, which shares every frame and backing store block of its
+    // parent until one of them writes to the page
+    void fork_process(int child_pid);
+
+    // run the references that come after this with the pages of another process
+    void switch_process(int pid);
+
+    // a process exits, its frames and backing store blocks are freed once no other process shares them
+    void exit_process(int pid);
+
+    // find the process with a pid, returns -1 if there is no such process running
+    int find_process(int pid);
+
+    // function to print the forks, copy-on-write faults, and sharing of the processes
+    void print_process_stats(OutputBuffer &output);
+
+    // take a page out of its frame, emptying the frame if no other process shares it
+    template <class Policy>
+    void unmap_page(Policy &policy, int page_number)
+    {
+        // update the page table
+        int frame_number = pages[page_number].frame_number;
+        Frame &frame = frames[frame_number];
+        pages[page_number].type = STOLEN;
+        pages[page_number].frame_number = -1;
+        tlb_invalidate(page_number);
+        frame.in_use--;
+
+        // the frame is left with the other processes sharing it, one of which it is now kept under
+        if (frame.in_use > 0)
+        {
+            frames_saved--;
+            for (int sharer = page_number % num_pages; frame.page_number == page_number && sharer < (int)pages.size(); sharer += num_pages)
+            {
+                if (pages[sharer].type == MAPPED && pages[sharer].frame_number == frame_number)
+                {
+                    frame.page_number = sharer;
+                }
+            }
+            return;
+        }
+
+        // otherwise the frame is empty
+        policy.removed(frame_number);
+        if (tiers_enabled)
+        {
+            tier_recency[frame_tier[frame_number]].remove(frame_number);
+        }
+        frame.page_number = -1;
+        set_dirty(frame, 0);
+        frame.first_use = -1;
+        frame.last_use = -1;
+        frame.prefetched = 0;
+        next_empty_frame = min(next_empty_frame, frame_number);
+    }
+
+    // free the pages, frames, and backing store blocks of a process that exited
+    template <class Policy>
+    void release_process_pages(Policy &policy, int process)
+    {
+        for (int page_number = process * num_pages; page_number < (process + 1) * num_pages; ++page_number)
+        {
+            if (pages[page_number].type == MAPPED)
+            {
+                unmap_page(policy, page_number);
+            }
+            if (pages[page_number].type != UNUSED)
+            {
+                pages_mapped--;
+            }
+            drop_block(page_number);
+            pages[page_number].type = UNUSED;
+        }
+    }
+
+    // give a process a copy of its own of a shared page it writes to, in an empty frame or one the policy steals
+    template <class Policy, class Trace>
+    void copy_on_write(Policy &policy, int page_number)
+    {
+        Trace::log(debug_output, "Copy-on-write fault");
+        cow_faults++;
+
+        // the page leaves the shared frame, which stays with the other processes
+        int shared_frame = pages[page_number].frame_number;
+        unmap_page(policy, page_number);
+
+        // find a frame for the copy (the shared frame itself can be stolen from the other processes)
+        bool wrote_back = false;
+        int frame_number = take_empty_frame();
+        if (frame_number == -1)
+        {
+            frame_number = policy.select_victim(victim_rank(false));
+            policy.template log_victim<Trace>(debug_output, frames, frame_number);
+            wrote_back = steal_frame<Policy, Trace>(policy, frame_number);
+        }
+        if (tiers_enabled && tier_placement == PLACE_FASTEST)
+        {
+            frame_number = demote_for_fill<Policy, Trace>(policy, frame_number);
+        }
+
+        // copy the page into the frame, which is dirty from the write
+        fill_frame(frame_number, page_number, 'w');
+        policy.loaded(frame_number, pages_referenced);
+        if (tiers_enabled)
+        {
+            tier_loaded(frame_number);
+        }
+        Trace::log(debug_output, "Page ", page_number, " copied from frame ", shared_frame, " to frame ", frame_number);
+        charge_reference(page_number, false, false, wrote_back, true);
+    }
+
+    // turn on the background flusher with watermarks given as a percent of the frames
+    void enable_flusher(int high_percent, int low_percent, int interval);
+
+    // run the background flusher, which writes dirty frames to swapspace ahead of eviction
+    template <class Policy, class Trace>
+    void run_flusher(Policy &policy)
+    {
+        // the flusher only wakes up once every interval, and has nothing to do until the dirty frames go over the high
+        // watermark
+        if (!flusher_enabled || pages_referenced % flusher_interval != 0 || (long long)num_dirty_frames * 100 <= (long long)flusher_high_watermark * num_frames)
+        {
+            return;
+        }
+
+        // write frames to swapspace in the order the policy would steal them until the dirty frames drop to the low
+        // watermark (a frame that cannot be written to the full backing store is left dirty)
+        policy.for_each_in_steal_order([this](int frame_number)
+        {
+            if ((long long)num_dirty_frames * 100 <= (long long)flusher_low_watermark * num_frames)
+            {
+                return false;
+            }
+            Frame &frame = frames[frame_number];
+            if (frame.dirty && can_write_back(frame))
+            {
+                write_frame_to_swapspace(frame_number);
+                set_dirty(frame, 0);
+                frames_cleaned_by_flusher++;
+                Trace::log(debug_output, "Flusher wrote frame ", frame_number, " to swapspace");
+            }
+            return true;
+        });
+    }
+
+    // set the dirty bit of a frame, keeping count of the dirty frames for the flusher
+    void set_dirty(Frame &frame, int dirty)
+    {
+        num_dirty_frames += dirty - frame.dirty;
+        frame.dirty = dirty;
+    }
+
+    // rank how good a frame is to steal: 0 is best, 1 is a dirty frame when clean frames are preferred, and -1 is a
+    // frame that must not be stolen
+    auto victim_rank(bool for_prefetch)
+    {
+        return [this, for_prefetch](int frame_number)
+        {
+            const Frame &frame = frames[frame_number];
+            if (for_prefetch && frame.first_use == pages_referenced)
+            {
+                return -1;
+            }
+            if (prefer_clean && frame.dirty)
+            {
+                return 1;
+            }
+            return 0;
+        };
+    }
+
+    // turn on the cost model with the given latencies
+    void enable_cost_model(const CostModel &cost_model);
+
+    // remove a page from the TLB (needed when the page loses its frame)
+    void tlb_invalidate(int page_number)
+    {
+        if (cost_enabled)
+        {
+            tlb.invalidate(page_number);
+        }
+    }
+
+    // charge the latency of one reference to the cost model (copied is true for a copy-on-write fault)
+    void charge_reference(int page_number, bool hit, bool major_fault, bool wrote_back, bool copied = false)
+    {
+        // nothing to do if the cost model is off
+        if (!cost_enabled)
+        {
+            return;
+        }
+
+        // every reference pays for the memory access itself, which depends on the tier of the page if memory has tiers
+        long long latency = tiers_enabled ? tiers[frame_tier[pages[page_number].frame_number]].latency : cost.hit;
+
+        // pay for the page walk on a TLB miss
+        if (!tlb.lookup(page_number))
+        {
+            tlb_misses++;
+            latency += cost.tlb_miss;
+        }
+
+        // pay for the fault and any writeback on the critical path
+        if (!hit)
+        {
+            latency += major_fault ? cost.major_fault : cost.minor_fault;
+        }
+        if (wrote_back)
+        {
+            latency += cost.writeback;
+        }
+        if (copied)
+        {
+            latency += cost.page_copy;
+        }
+
+        // add the latency to the total and to the histogram
+        record_latency(latency, 1);
+    }
+
+    // add the latency of a number of references to the total and to the histogram
+    void record_latency(long long latency, int references)
+    {
+        estimated_time += latency * references;
+        int bucket = 0;
+        while (bucket < LATENCY_BUCKETS - 1 && (1LL << bucket) < latency)
+        {
+            bucket++;
+        }
+        latency_histogram[bucket] += references;
+    }
+
+    // charge a number of hits in a row on the page that was just referenced, which are all TLB hits
+    void charge_repeated_hits(int page_number, int repeats)
+    {
+        if (!cost_enabled)
+        {
+            return;
+        }
+
+        // the first hit goes through the TLB so its entry is marked as used last, the rest only cost the access
+        charge_reference(page_number, true, false, false);
+        record_latency(cost.hit, repeats - 1);
+    }
+
+    // function to print the estimated execution time from the cost model
+    void print_cost_summary(OutputBuffer &output);
+
+    // find the lowest numbered empty frame and return it (-1 if every frame is in use)
+    int take_empty_frame()
+    {
+        while (next_empty_frame < num_frames && frames[next_empty_frame].in_use)
+        {
+            next_empty_frame++;
+        }
+        return next_empty_frame < num_frames ? next_empty_frame : -1;
+    }
+
+    // steal a frame from the page in it, returns true if the page had to be written to swapspace
+    template <class Policy, class Trace>
+    bool steal_frame(Policy &policy, int frame_number)
+    {
+        Frame &frame = frames[frame_number];
+
+        // write the stolen frame to swapspace if dirty
+        bool wrote_back = frame.dirty;
+        if (frame.dirty)
+        {
+            write_frame_to_swapspace(frame_number);
+            stolen_frames_written_to_swapspace++;
+            Trace::log(debug_output, "Frame ", frame_number, " stolen and written to swapspace");
+        }
+
+        // update the page table for the page being replaced, in every process sharing it
+        for_each_sharer(frame_number, [this](int sharer)
+        {
+            pages[sharer].type = STOLEN;
+            pages[sharer].frame_number = -1;
+            tlb_invalidate(sharer);
+        });
+        frames_saved -= frame.in_use - 1;
+        frame_stolen_instances++;
+
+        // a prefetched page stolen before it was used polluted memory
+        if (frame.prefetched)
+        {
+            prefetched_pages_evicted_unused++;
+            frame.prefetched = 0;
+        }
+        policy.removed(frame_number);
+        if (tiers_enabled)
+        {
+            tier_recency[frame_tier[frame_number]].remove(frame_number);
+        }
+        Trace::log(debug_output, "Stolen frame updated in page table");
+        return wrote_back;
+    }
+
+    // put a page into a frame and map it in the page table
+    void fill_frame(int frame_number, int page_number, char operation)
+    {
+        // update the frame table
+        Frame &frame = frames[frame_number];
+        frame.page_number = page_number;
+        frame.first_use = pages_referenced;
+        frame.last_use = pages_referenced;
+        frame.in_use = 1;
+        set_dirty(frame, operation == 'w');
+        frame.prefetched = 0;
+
+        // update the page table
+        pages[page_number].frame_number = frame_number;
+        mark_page_mapped(page_number);
+    }
+
+    // run one reference, the replacement policy picks the frames to steal, the tracing policy decides on the debug output,
+    // and the profiling policy decides if the phases are timed
+    template <class Policy, class Trace, class Profile>
+    void run_reference(Policy &policy, char operation, int address)
+    {
+        // get the page number
+        int page_number = address / page_size;
+        if (page_number >= num_pages)
+        {
+            throw runtime_error("Page number out of range");
+        }
+        if (current_process == -1)
+        {
+            throw runtime_error("No process is running");
+        }
+        page_number += page_base;
+
+        // write the streaming statistics and let the background flusher clean frames before the reference
+        Profile::enter(profiler, PHASE_BACKGROUND);
+        stats_tick();
+        run_flusher<Policy, Trace>(policy);
+
+        // increment the pages referenced
+        pages_referenced++;
+
+        // check if the page is already in memory
+        Profile::enter(profiler, PHASE_LOOKUP);
+        Page &page = pages[page_number];
+        if (page.type == MAPPED)
+        {
+            // a write to a page shared with another process copies the page to a frame of its own first
+            Frame &frame = frames[page.frame_number];
+            if (operation == 'w' && frame.in_use > 1)
+            {
+                Profile::enter(profiler, PHASE_VICTIM);
+                copy_on_write<Policy, Trace>(policy, page_number);
+                Profile::enter(profiler, NO_PHASE);
+                return;
+            }
+
+            // update the last use and set the dirty bit if write operation
+            frame.last_use = pages_referenced;
+            if (operation == 'w')
+            {
+                set_dirty(frame, 1);
+            }
+            policy.touched(frame.frame_number, pages_referenced);
+            if (tiers_enabled)
+            {
+                tier_touched(frame.frame_number);
+            }
+            Trace::log(debug_output, "Page hit");
+
+            // charge the hit to the cost model, count the hit if the page was prefetched, and move the page to a faster
+            // tier if it is hot
+            charge_reference(page_number, true, false, false);
+            Profile::enter(profiler, PHASE_PREFETCH);
+            prefetch_hit<Policy, Trace>(policy, frame);
+            if (tiers_enabled)
+            {
+                promote_page<Policy, Trace>(policy, page_number);
+            }
+            Profile::enter(profiler, NO_PHASE);
+            return;
+        }
+
+        // page miss
+        Trace::log(debug_output, "Page miss");
+        page_miss_instances++;
+
+        // use an empty frame if there is one, otherwise steal the frame the policy picks
+        Profile::enter(profiler, PHASE_VICTIM);
+        bool wrote_back = false;
+        int frame_number = take_empty_frame();
+        bool stolen = frame_number == -1;
+        if (!stolen)
+        {
+            Trace::log(debug_output, "Empty frame found at frame ", frame_number);
+        }
+        else
+        {
+            frame_number = policy.select_victim(victim_rank(false));
+            policy.template log_victim<Trace>(debug_output, frames, frame_number);
+            wrote_back = steal_frame<Policy, Trace>(policy, frame_number);
+        }
+
+        // with tiers the page goes in the fastest tier, moving pages down to make room for it
+        if (tiers_enabled && tier_placement == PLACE_FASTEST)
+        {
+            frame_number = demote_for_fill<Policy, Trace>(policy, frame_number);
+        }
+
+        // recover the page from swapspace if it was previously written there
+        Profile::enter(profiler, PHASE_FILL);
+        bool recovered = false;
+        if (page.on_disk == 1)
+        {
+            recovered = true;
+            stolen_frames_recovered_from_swapspace++;
+            read_from_swapspace(page_number);
+            Trace::log(debug_output, "Page ", page_number, " recovered from swapspace");
+        }
+
+        // update the frame and page tables
+        fill_frame(frame_number, page_number, operation);
+        policy.loaded(frame_number, pages_referenced);
+        if (tiers_enabled)
+        {
+            tier_loaded(frame_number);
+        }
+        if (stolen)
+        {
+            Trace::log(debug_output, Policy::victim_name, " frame updated in frame table");
+        }
+        else if (operation == 'w')
+        {
+            Trace::log(debug_output, "Dirty bit set");
+        }
+
+        // charge the fault (and any writeback) to the cost model and bring in the pages the prefetcher expects next
+        charge_reference(page_number, false, recovered, wrote_back);
+        Profile::enter(profiler, PHASE_PREFETCH);
+        prefetch<Policy, Trace>(policy, page_number, recovered);
+        Profile::enter(profiler, NO_PHASE);
+    }
+
+    // run the FIFO algorithm for one reference
+    template <class Trace, class Profile>
+    void run_fifo_algorithm(char operation, int address)
+    {
+        run_reference<FifoPolicy, Trace, Profile>(fifo_policy, operation, address);
+    }
+
+    // run the LRU algorithm for one reference
+    template <class Trace, class Profile>
+    void run_lru_algorithm(char operation, int address)
+    {
+        run_reference<LruPolicy, Trace, Profile>(lru_policy, operation, address);
+    }
+
+    // run the OPT algorithm for one reference (set_future_references has to be called first)
+    template <class Trace, class Profile>
+    void run_opt_algorithm(char operation, int address)
+    {
+        run_reference<OptPolicy, Trace, Profile>(opt_policy, operation, address);
+    }
+
+    // give OPT the page numbers of every reference in the trace
+    void set_future_references(const vector<int> &page_numbers)
+    {
+        opt_policy.set_future_references(page_numbers, num_pages);
+    }
+
+    // only let OPT look at the next references instead of the whole trace, references are held back until the window
+    // after them is full
+    void set_opt_window(int window)
+    {
+        opt_window = window;
+        opt_policy.set_window(window, num_pages);
+        lookahead = RingBuffer<Reference>(window + 1);
+        select_reference_handler();
+    }
+
+    // run the oldest reference held back for windowed OPT
+    template <class Trace, class Profile>
+    void run_lookahead_reference()
+    {
+        Reference reference = lookahead.front();
+        lookahead.pop_front();
+        run_reference<OptPolicy, Trace, Profile>(opt_policy, reference.operation, reference.address);
+    }
+
+    // give windowed OPT one reference, running the oldest one once it can see a full window after it
+    template <class Trace, class Profile>
+    void run_opt_window_algorithm(char operation, int address)
+    {
+        long long index = pages_referenced + (long long)lookahead.size();
+        lookahead.push_back(Reference{operation, address});
+        opt_policy.add_to_window(address / page_size + page_base, pages_referenced, index);
+        if ((int)lookahead.size() > opt_window)
+        {
+            run_lookahead_reference<Trace, Profile>();
+        }
+    }
+
+    // run the references held back for windowed OPT, at the end of the trace or before the state is looked at
+    void finish_lookahead()
+    {
+        while (!lookahead.empty())
+        {
+            (this->*lookahead_handler)();
+        }
+    }
+
+    // run the rest of a run of references to one page (given with a repeat count), which are hits that only move the
+    // page to the back of the LRU list and add up in the counters, so they are run all at once
+    template <class Policy, class Trace, class Profile>
+    void repeat_reference(Policy &policy, char operation, int address, int repeats)
+    {
+        // run the references one by one if something can happen between them (debug messages, the flusher, the
+        // streaming statistics, the next uses of OPT, promotion between tiers, or the page was stolen by the prefetcher)
+        int page_number = address / page_size + page_base;
+        bool one_by_one = !Policy::bulk_repeats || is_same<Trace, DebugTrace>::value || flusher_enabled || stats_out != nullptr || tiers_enabled;
+        while (repeats > 0 && (one_by_one || pages[page_number].type != MAPPED))
+        {
+            run_reference<Policy, Trace, Profile>(policy, operation, address);
+            repeats--;
+        }
+        if (repeats == 0)
+        {
+            return;
+        }
+
+        // the rest are hits on the page
+        Profile::enter(profiler, PHASE_LOOKUP);
+        pages_referenced += repeats;
+        Frame &frame = frames[pages[page_number].frame_number];
+        frame.last_use = pages_referenced;
+        if (operation == 'w')
+        {
+            set_dirty(frame, 1);
+        }
+        policy.touched(frame.frame_number, pages_referenced);
+        charge_repeated_hits(page_number, repeats);
+        Profile::enter(profiler, NO_PHASE);
+    }
+
+    // run a batch of references with one replacement policy
+    template <class Policy, class Trace, class Profile>
+    void run_batch(Policy &policy, const Reference *references, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            run_reference<Policy, Trace, Profile>(policy, references[i].operation, references[i].address);
+            if (references[i].count > 1)
+            {
+                repeat_reference<Policy, Trace, Profile>(policy, references[i].operation, references[i].address, references[i].count - 1);
+            }
+        }
+    }
+
+    // run a batch of references with the FIFO algorithm
+    template <class Trace, class Profile>
+    void run_fifo_batch(const Reference *references, size_t count)
+    {
+        run_batch<FifoPolicy, Trace, Profile>(fifo_policy, references, count);
+    }
+
+    // run a batch of references with the LRU algorithm
+    template <class Trace, class Profile>
+    void run_lru_batch(const Reference *references, size_t count)
+    {
+        run_batch<LruPolicy, Trace, Profile>(lru_policy, references, count);
+    }
+
+    // run a batch of references with the OPT algorithm
+    template <class Trace, class Profile>
+    void run_opt_batch(const Reference *references, size_t count)
+    {
+        run_batch<OptPolicy, Trace, Profile>(opt_policy, references, count);
+    }
+
+    // give a batch of references to windowed OPT
+    template <class Trace, class Profile>
+    void run_opt_window_batch(const Reference *references, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            for (int repeat = 0; repeat < references[i].count; ++repeat)
+            {
+                run_opt_window_algorithm<Trace, Profile>(references[i].operation, references[i].address);
+            }
+        }
+    }
+
+    // pick the compiled version of the algorithm for the tracing and profiling policies
+    template <class Trace, class Profile>
+    void select_reference_handler()
+    {
+        if (algorithm == Algorithm::FIFO)
+        {
+            reference_handler = &VirtualMemoryEngine::run_fifo_algorithm<Trace, Profile>;
+            batch_handler = &VirtualMemoryEngine::run_fifo_batch<Trace, Profile>;
+        }
+        else if (algorithm == Algorithm::LRU)
+        {
+            reference_handler = &VirtualMemoryEngine::run_lru_algorithm<Trace, Profile>;
+            batch_handler = &VirtualMemoryEngine::run_lru_batch<Trace, Profile>;
+        }
+        else if (opt_window == 0)
+        {
+            reference_handler = &VirtualMemoryEngine::run_opt_algorithm<Trace, Profile>;
+            batch_handler = &VirtualMemoryEngine::run_opt_batch<Trace, Profile>;
+        }
+        else
+        {
+            reference_handler = &VirtualMemoryEngine::run_opt_window_algorithm<Trace, Profile>;
+            batch_handler = &VirtualMemoryEngine::run_opt_window_batch<Trace, Profile>;
+        }
+        lookahead_handler = &VirtualMemoryEngine::run_lookahead_reference<Trace, Profile>;
+    }
+
+    // pick the compiled version of the algorithm for the debug and profiling settings, so neither is checked per reference
+    void select_reference_handler()
+    {
+        if (debug_output != nullptr)
+        {
+            profiler != nullptr ? select_reference_handler<DebugTrace, PhaseProfile>() : select_reference_handler<DebugTrace, NoProfile>();
+        }
+        else
+        {
+            profiler != nullptr ? select_reference_handler<NoTrace, PhaseProfile>() : select_reference_handler<NoTrace, NoProfile>();
+        }
+    }
+
+    // print the debug messages to output, or turn debugging off if it is null
+    void set_debug(OutputBuffer *output)
+    {
+        debug_output = output;
+        select_reference_handler();
+    }
+
+    // turn on the per-phase profiling of each reference
+    void enable_profiling(Profiler &phase_profiler)
+    {
+        profiler = &phase_profiler;
+        select_reference_handler();
+    }
+
+    // run one reference with the algorithm of the virtual memory (windowed OPT holds it back until finish_lookahead or
+    // until the window after it is full)
+    void access(char operation, int address)
+    {
+        (this->*reference_handler)(operation, address);
+    }
+
+    // run a reference repeated count times in a row
+    void access(char operation, int address, int count)
+    {
+        Reference reference = {operation, address, count};
+        access_batch(&reference, 1);
+    }
+
+    // run a batch of references, the algorithm is only looked up once for the whole batch
+    void access_batch(const Reference *references, size_t count)
+    {
+        (this->*batch_handler)(references, count);
+    }
+
+    // run a batch of references held in a vector
+    void access_batch(const vector<Reference> &references)
+    {
+        access_batch(references.data(), references.size());
+    }
+
+    // get the counters of the run so far
+    VirtualMemoryStats stats() const;
+};
+
+#endif